@@ -0,0 +1,388 @@
+/*
+  ==============================================================================
+
+    This file contains the basic startup code for a JUCE application.
+
+    TableTennisRender - headless offline renderer. Runs TableTennisAudioProcessor
+    directly over a WAV/AIFF file, or a whole directory of stems, with one
+    processor instance per worker thread.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+
+//==============================================================================
+/** Everything that applies to every file in a run. */
+struct RenderSettings
+{
+    juce::File outputDirectory;
+    juce::MemoryBlock state;                      // Optional state file, applied before the parameter overrides
+    juce::StringPairArray parameters;             // paramID -> value, in the parameter's own units
+    int blockSize = 512;
+    double extraTailSeconds = 0.0;                // Rendered on top of whatever tail the processor reports
+    double bpm = TempoSync::defaultBpm;           // Tempo for synced delay times - there's no host to ask
+};
+
+/** Stands in for a host's play head, at a fixed tempo. */
+struct RenderPlayHead : public juce::AudioPlayHead
+{
+    bool getCurrentPosition(CurrentPositionInfo& result) override
+    {
+        result.resetToDefault();
+        result.bpm = bpm;
+        return true;
+    }
+
+    double bpm = TempoSync::defaultBpm;
+};
+
+/** What gets reported for each file. */
+struct RenderResult
+{
+    juce::File input;
+    bool ok = false;
+    juce::String error;
+    juce::int64 numSamples = 0;                   // Sample frames rendered, including the tail
+    double sampleRate = 0.0;
+    double processSeconds = 0.0;                  // Time spent inside processBlock only
+};
+
+//==============================================================================
+static bool applyParameter(juce::AudioProcessor& processor, const juce::String& paramID, float value)
+{
+    for (auto* param : processor.getParameters())
+    {
+        auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(param);
+
+        if (ranged != nullptr && ranged->paramID == paramID)
+        {
+            ranged->setValueNotifyingHost(ranged->convertTo0to1(value));
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void applySettings(juce::AudioProcessor& processor, const RenderSettings& settings)
+{
+    if (settings.state.getSize() > 0)
+        processor.setStateInformation(settings.state.getData(), (int) settings.state.getSize());
+
+    for (auto& paramID : settings.parameters.getAllKeys())
+        applyParameter(processor, paramID, settings.parameters[paramID].getFloatValue());
+}
+
+//==============================================================================
+/** Renders one file with the given processor. */
+static RenderResult renderFile(juce::AudioProcessor& processor, juce::AudioFormatManager& formatManager,
+                               const juce::File& input, const RenderSettings& settings)
+{
+    RenderResult result;
+    result.input = input;
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(input));
+
+    if (reader == nullptr)
+    {
+        result.error = "couldn't open file";
+        return result;
+    }
+
+    // The whole file is rendered in one buffer, indexed by int - anything longer would be cut short without a word
+    if (reader->lengthInSamples > (juce::int64) std::numeric_limits<int>::max())
+    {
+        result.error = "too long (" + juce::String(reader->lengthInSamples) + " samples - the most is " + juce::String(std::numeric_limits<int>::max()) + ")";
+        return result;
+    }
+
+    auto sampleRate = reader->sampleRate;
+    auto numInputSamples = (int) reader->lengthInSamples;
+    auto numInputChannels = (int) reader->numChannels;
+    auto numChannels = juce::jmax(2, numInputChannels); // Surround files keep their channels, mono files are fed to both inputs of a stereo bus
+
+    juce::AudioBuffer<float> source(numInputChannels, numInputSamples);
+    reader->read(&source, 0, numInputSamples, 0, true, true);
+
+    processor.setPlayConfigDetails(numChannels, numChannels, sampleRate, settings.blockSize);
+
+    if (processor.getTotalNumOutputChannels() != numChannels)
+    {
+        result.error = "unsupported channel count (" + juce::String(numInputChannels) + ")";
+        return result;
+    }
+
+    RenderPlayHead playHead;
+    playHead.bpm = settings.bpm;
+    processor.setPlayHead(&playHead);
+    processor.setNonRealtime(true);
+    processor.prepareToPlay(sampleRate, settings.blockSize);
+
+    juce::AudioBuffer<float> block(numChannels, settings.blockSize);
+    juce::MidiBuffer midi;
+    block.setSize(numChannels, 0, false, false, true);
+    processor.processBlock(block, midi); // An empty block, so the processor has read the tempo before it's asked for its tail
+
+    auto tailSamples = std::ceil((processor.getTailLengthSeconds() + settings.extraTailSeconds) * sampleRate);
+
+    if ((double) numInputSamples + tailSamples > (double) std::numeric_limits<int>::max())
+    {
+        processor.releaseResources();
+        processor.setPlayHead(nullptr);
+        result.error = "too long with its tail";
+        return result;
+    }
+
+    auto numSamples = numInputSamples + (int) tailSamples;
+
+    juce::AudioBuffer<float> rendered(numChannels, numSamples);
+    juce::int64 ticks = 0;
+
+    for (int start = 0; start < numSamples; start += settings.blockSize)
+    {
+        auto blockLength = juce::jmin(settings.blockSize, numSamples - start);
+        block.setSize(numChannels, blockLength, false, false, true);
+        block.clear();
+
+        auto numToCopy = juce::jlimit(0, blockLength, numInputSamples - start);
+
+        for (int channel = 0; channel < numChannels && numToCopy > 0; ++channel)
+            block.copyFrom(channel, 0, source, juce::jmin(channel, numInputChannels - 1), start, numToCopy);
+
+        auto before = juce::Time::getHighResolutionTicks();
+        processor.processBlock(block, midi);
+        ticks += juce::Time::getHighResolutionTicks() - before;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            rendered.copyFrom(channel, start, block, channel, 0, blockLength);
+    }
+
+    processor.releaseResources();
+    processor.setPlayHead(nullptr);
+
+    // Write the result next to its siblings in the output directory, in the same format as the input. It goes to a temporary file first,
+    // which only replaces one already there once it's all written - a failed write leaves the old one alone
+    auto output = settings.outputDirectory.getChildFile(input.getFileName());
+    auto* format = formatManager.findFormatForFileExtension(input.getFileExtension());
+    juce::TemporaryFile temporary(output);
+
+    auto stream = std::make_unique<juce::FileOutputStream>(temporary.getFile());
+    std::unique_ptr<juce::AudioFormatWriter> writer;
+
+    if (format != nullptr && stream->openedOk())
+        writer.reset(format->createWriterFor(stream.get(), sampleRate, (unsigned int) numChannels,
+                                             juce::jmax(16, (int) reader->bitsPerSample), {}, 0));
+
+    if (writer == nullptr)
+    {
+        result.error = "couldn't write " + output.getFullPathName();
+        return result;
+    }
+
+    stream.release(); // The writer owns the stream now
+    auto written = writer->writeFromAudioSampleBuffer(rendered, 0, numSamples);
+    writer.reset(); // Flushes and closes the temporary file
+
+    if (! written || ! temporary.overwriteTargetFileWithTemporary())
+    {
+        result.error = "couldn't write " + output.getFullPathName();
+        return result;
+    }
+
+    result.ok = true;
+    result.numSamples = numSamples;
+    result.sampleRate = sampleRate;
+    result.processSeconds = juce::Time::highResolutionTicksToSeconds(ticks);
+    return result;
+}
+
+//==============================================================================
+/** Pulls files off a shared list until it runs out. Each worker owns its own processor instance. */
+class RenderWorker : public juce::Thread
+{
+public:
+    RenderWorker(const juce::Array<juce::File>& filesToRender, std::atomic<int>& nextFileIndex,
+                 const RenderSettings& renderSettings, juce::CriticalSection& reportLock)
+        : juce::Thread("TableTennis render worker"), files(filesToRender), nextFile(nextFileIndex),
+          settings(renderSettings), lock(reportLock)
+    {
+        formatManager.registerBasicFormats();
+        applySettings(processor, settings);
+    }
+
+    void run() override
+    {
+        for (auto index = nextFile++; index < files.size() && ! threadShouldExit(); index = nextFile++)
+        {
+            auto result = renderFile(processor, formatManager, files.getReference(index), settings);
+            report(result);
+
+            if (! result.ok)
+                failed = true;
+        }
+    }
+
+    bool hasFailures() const noexcept { return failed; }
+
+private:
+    void report(const RenderResult& result)
+    {
+        const juce::ScopedLock sl(lock);
+
+        if (! result.ok)
+        {
+            std::cout << result.input.getFileName() << ": FAILED - " << result.error << std::endl;
+            return;
+        }
+
+        auto audioSeconds = (double) result.numSamples / result.sampleRate;
+        auto processSeconds = juce::jmax(result.processSeconds, 1.0e-9);
+
+        std::cout << result.input.getFileName() << ": "
+                  << juce::String(audioSeconds, 2) << " s audio in "
+                  << juce::String(processSeconds, 3) << " s, "
+                  << juce::String(audioSeconds / processSeconds, 1) << "x realtime, "
+                  << juce::String((double) result.numSamples / processSeconds, 0) << " samples/sec" << std::endl;
+    }
+
+    TableTennisAudioProcessor processor;
+    juce::AudioFormatManager formatManager;
+
+    const juce::Array<juce::File>& files;
+    std::atomic<int>& nextFile;
+    const RenderSettings& settings;
+    juce::CriticalSection& lock;
+    bool failed = false;
+};
+
+//==============================================================================
+static void printUsage()
+{
+    std::cout << "Usage: TableTennisRender <input file or directory> <output directory> [options]" << std::endl
+              << std::endl
+              << "  --params=id=value,...   Parameter values, e.g. --params=delayTime=375,feedback=0.5,wetDry=0.4" << std::endl
+              << "                          (ids: " << juce::StringArray(ParameterSnapshot::parameterIDs, ParameterSnapshot::numValues).joinIntoString(", ") << ")" << std::endl
+              << "  --state=<file>          Load a saved plugin state before applying --params" << std::endl
+              << "  --threads=<n>           Worker threads (default: number of CPU cores)" << std::endl
+              << "  --block=<n>             Block size passed to processBlock (default: 512)" << std::endl
+              << "  --tail=<seconds>        Extra silence to render after each file (default: 0)" << std::endl
+              << "  --bpm=<n>               Tempo for synced delay times, e.g. --params=sync=1,division=8 (default: 120)" << std::endl
+              << std::endl
+              << "Set TENNISBOY_KERNELS to scalar, sse2, avx2, avx512 or neon to force the delay kernels' instruction set." << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser; // Parameters and the value tree expect a message manager to exist
+
+    juce::ArgumentList args(argc, argv);
+    juce::StringArray positional;
+
+    for (auto& arg : args.arguments)
+        if (! arg.isOption())
+            positional.add(arg.text);
+
+    if (args.containsOption("--help|-h") || positional.size() != 2)
+    {
+        printUsage();
+        return positional.size() == 2 ? 0 : 1;
+    }
+
+    juce::File input(juce::File::getCurrentWorkingDirectory().getChildFile(positional[0]));
+    RenderSettings settings;
+    settings.outputDirectory = juce::File::getCurrentWorkingDirectory().getChildFile(positional[1]);
+    settings.extraTailSeconds = juce::jmax(0.0, args.getValueForOption("--tail").getDoubleValue());
+
+    if (args.containsOption("--bpm"))
+        settings.bpm = juce::jmax(1.0, args.getValueForOption("--bpm").getDoubleValue());
+
+    if (args.containsOption("--block"))
+        settings.blockSize = juce::jmax(1, args.getValueForOption("--block").getIntValue());
+
+    if (args.containsOption("--state"))
+    {
+        juce::File stateFile(juce::File::getCurrentWorkingDirectory().getChildFile(args.getValueForOption("--state")));
+
+        if (! stateFile.loadFileAsData(settings.state))
+        {
+            std::cout << "Couldn't read state file " << stateFile.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+
+    for (auto& pair : juce::StringArray::fromTokens(args.getValueForOption("--params"), ",", {}))
+        if (pair.containsChar('='))
+            settings.parameters.set(pair.upToFirstOccurrenceOf("=", false, false).trim(),
+                                    pair.fromFirstOccurrenceOf("=", false, false).trim());
+
+    // Gather the files to render
+    juce::Array<juce::File> files;
+
+    if (input.isDirectory())
+        files = input.findChildFiles(juce::File::findFiles, false, "*.wav;*.aif;*.aiff");
+    else if (input.existsAsFile())
+        files.add(input);
+
+    if (files.isEmpty())
+    {
+        std::cout << "Nothing to render in " << input.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    // Each output takes its input's name, so writing into a directory an input is in would replace the input
+    for (auto& file : files)
+    {
+        if (file.getParentDirectory() == settings.outputDirectory)
+        {
+            std::cout << "The output directory can't be the one " << file.getFileName() << " is in - it would be overwritten" << std::endl;
+            return 1;
+        }
+    }
+
+    if (! settings.outputDirectory.createDirectory())
+    {
+        std::cout << "Couldn't create " << settings.outputDirectory.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    auto numThreads = args.containsOption("--threads") ? args.getValueForOption("--threads").getIntValue()
+                                                       : juce::SystemStats::getNumCpus();
+    numThreads = juce::jlimit(1, files.size(), numThreads);
+
+    // One processor per worker; workers take the next file off the list when they finish one
+    std::atomic<int> nextFile { 0 };
+    juce::CriticalSection reportLock;
+    juce::OwnedArray<RenderWorker> workers;
+
+    for (int i = 0; i < numThreads; ++i)
+        workers.add(new RenderWorker(files, nextFile, settings, reportLock));
+
+    auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+    for (auto* worker : workers)
+        worker->startThread();
+
+    bool failed = false;
+
+    for (auto* worker : workers)
+    {
+        worker->waitForThreadToExit(-1);
+        failed = failed || worker->hasFailures();
+    }
+
+    auto wallSeconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+    std::cout << "Rendered " << files.size() << " file(s) on " << numThreads << " thread(s) in "
+              << juce::String(wallSeconds, 2) << " s with " << SimdKernels::getName(SimdKernels::getPreferredIsa()) << " kernels" << std::endl;
+
+    // Checked (Debug) builds count every allocation or lock made inside processBlock
+    if (RealtimeSafety::getNumViolations() > 0)
+    {
+        std::cout << "Realtime safety: " << RealtimeSafety::getNumViolations() << " allocation/lock call(s) inside processBlock, first was "
+                  << RealtimeSafety::getFirstViolation() << std::endl;
+        failed = true;
+    }
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,173 @@
+/*
+  ==============================================================================
+
+    DelayInterpolation.h
+
+    Interpolation policies for the delay taps. PingPongKernel is templated on
+    one of these, so choosing a quality picks a whole specialised kernel once
+    per block and the inner loop never branches on the interpolation type.
+
+    The maths matches juce::dsp::DelayLineInterpolationTypes, except that None
+    rounds to the nearest sample instead of truncating.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace DelayInterpolation
+{
+    /** A delay split up the way a policy wants to read it: 'whole' is the newest
+        point it reads, 'frac' the fractional position from there and 'alpha' any
+        per-delay coefficient (Thiran only).
+    */
+    struct Tap
+    {
+        int whole = 0;
+        float frac = 0.0f;
+        float alpha = 0.0f;
+    };
+
+    /** Broadcasts a constant to a float, a double or a SIMDRegister of either. */
+    template <typename T>
+    inline T splat(double value) noexcept
+    {
+        if constexpr (std::is_floating_point_v<T>)
+            return (T) value;
+        else
+            return T::expand((typename T::ElementType) value);
+    }
+
+    //==============================================================================
+    /*  Each policy provides:
+            numPoints    - how many consecutive samples it reads, from 'whole' backwards in time
+            isRecursive  - true if it carries state from one sample to the next (so can't run frames in parallel)
+            makeTap()    - splits a delay in samples into a Tap
+            interpolate() - points[k] is the sample delayed by whole + k, for float, double or a SIMD register of either
+
+        SimdKernels' tap reads write the non-recursive ones out again for whole lanes - the two must do the same arithmetic.
+    */
+
+    /** No interpolation - nearest sample. The cheapest by far, but modulated delays will zipper. */
+    struct None
+    {
+        static constexpr int numPoints = 1;
+        static constexpr bool isRecursive = false;
+
+        static Tap makeTap(float delayInSamples) noexcept
+        {
+            return { juce::roundToInt(delayInSamples), 0.0f, 0.0f };
+        }
+
+        template <typename T>
+        static T interpolate(const T* points, T, T, T&) noexcept
+        {
+            return points[0];
+        }
+    };
+
+    /** Straight-line interpolation between two samples. The original TENNISBOY sound. */
+    struct Linear
+    {
+        static constexpr int numPoints = 2;
+        static constexpr bool isRecursive = false;
+
+        static Tap makeTap(float delayInSamples) noexcept
+        {
+            auto whole = (int) std::floor(delayInSamples);
+            return { whole, delayInSamples - (float) whole, 0.0f };
+        }
+
+        template <typename T>
+        static T interpolate(const T* points, T frac, T, T&) noexcept
+        {
+            return points[0] + frac * (points[1] - points[0]);
+        }
+    };
+
+    /** Third order Lagrange over four samples, centred on the tap. Flatter response for modulated delays. */
+    struct Lagrange3
+    {
+        static constexpr int numPoints = 4;
+        static constexpr bool isRecursive = false;
+
+        static Tap makeTap(float delayInSamples) noexcept
+        {
+            auto tap = Linear::makeTap(delayInSamples);
+
+            if (tap.whole >= 1) // Read one sample newer so the fraction sits between the middle two points
+            {
+                --tap.whole;
+                tap.frac += 1.0f;
+            }
+
+            return tap;
+        }
+
+        template <typename T>
+        static T interpolate(const T* points, T frac, T, T&) noexcept
+        {
+            auto d1 = frac - splat<T>(1.0);
+            auto d2 = frac - splat<T>(2.0);
+            auto d3 = frac - splat<T>(3.0);
+
+            auto c1 = d1 * d2 * d3 * splat<T>(-1.0 / 6.0);
+            auto c2 = d2 * d3 * splat<T>(0.5);
+            auto c3 = d1 * d3 * splat<T>(-0.5);
+            auto c4 = d1 * d2 * splat<T>(1.0 / 6.0);
+
+            return points[0] * c1 + frac * (points[1] * c2 + points[2] * c3 + points[3] * c4);
+        }
+    };
+
+    /** First order Thiran allpass. Flat magnitude at every delay, but recursive, so frames go one at a time. */
+    struct Thiran
+    {
+        static constexpr int numPoints = 2;
+        static constexpr bool isRecursive = true;
+
+        static Tap makeTap(float delayInSamples) noexcept
+        {
+            auto tap = Linear::makeTap(delayInSamples);
+
+            if (tap.frac < 0.618f && tap.whole >= 1) // Keep the fraction where the allpass is well behaved
+            {
+                --tap.whole;
+                tap.frac += 1.0f;
+            }
+
+            tap.alpha = (1.0f - tap.frac) / (1.0f + tap.frac);
+            return tap;
+        }
+
+        template <typename T>
+        static T interpolate(const T* points, T frac, T alpha, T& state) noexcept
+        {
+            static_assert(std::is_floating_point_v<T>, "Thiran is recursive - it only runs one sample at a time");
+
+            auto output = frac == (T) 0 ? points[0] : points[1] + alpha * (points[0] - state);
+            state = output;
+            return output;
+        }
+    };
+
+    /** Largest numPoints of any policy - the DelayRing is sized to allow for it. */
+    static constexpr int maxNumPoints = 4;
+
+    //==============================================================================
+    /** Quality settings, in the order of the "quality" parameter's choices. */
+    enum class Quality
+    {
+        none = 0,
+        linear,
+        lagrange3,
+        thiran
+    };
+
+    inline juce::StringArray getQualityNames()
+    {
+        return { "None", "Linear", "Lagrange3", "Thiran" };
+    }
+}
@@ -0,0 +1,129 @@
+/*
+  ==============================================================================
+
+    DelayRing.h
+
+    Interleaved multichannel delay buffer with a mirrored tail, read and
+    written a block at a time instead of one sample at a time.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Ring buffer of interleaved frames for the delay lines.
+
+    The first 'mirror' frames of the ring are duplicated after its end, so any
+    span of up to getMaximumSpan() + 1 frames can be addressed through a single
+    pointer, whatever the read position is. A block of delayed samples is then one
+    contiguous run of memory instead of a wrap check per sample.
+
+    Writes are zero-copy too: write straight through getWritePointer(), then call
+    advance() to publish the frames and keep the mirror in sync.
+
+    SampleType is float or double.
+*/
+template <typename SampleType>
+class DelayRing
+{
+public:
+    DelayRing() = default;
+
+    //==============================================================================
+    /** Allocates the ring. maximumSpan is the longest block that will be read or written in one go. Not realtime safe. */
+    void prepare(int numChannelsToUse, int maximumDelayInSamples, int maximumSpan)
+    {
+        numChannels = juce::jmax(1, numChannelsToUse);
+        maxDelay = juce::jmax(1, maximumDelayInSamples);
+        maxSpan = juce::jmax(1, maximumSpan);
+        mirror = maxSpan + 1;
+
+        // One frame for the interpolator and one for the frame being written, and never shorter than the mirror
+        size = juce::jmax(maxDelay + 2, mirror);
+
+        storage.assign((size_t) ((size + mirror) * numChannels), SampleType());
+        writePos = 0;
+    }
+
+    /** Frees the ring until the next prepare(). Not realtime safe. */
+    void release()
+    {
+        storage = {};
+        writePos = 0;
+    }
+
+    /** Clears the ring. */
+    void reset() noexcept
+    {
+        std::fill(storage.begin(), storage.end(), SampleType());
+        writePos = 0;
+    }
+
+    //==============================================================================
+    int getNumChannels() const noexcept         { return numChannels; }
+    int getMaximumDelayInSamples() const noexcept { return maxDelay; }
+    int getMaximumSpan() const noexcept         { return maxSpan; }
+
+    /** Returns the frame written delayInSamples frames before the next write position.
+
+        The returned pointer is contiguous for getMaximumSpan() + 1 frames (interleaved,
+        getNumChannels() samples per frame), so a block read is a straight walk forward.
+        delayInSamples must be between 0 and getMaximumDelayInSamples() + 1.
+    */
+    const SampleType* getReadPointer(int delayInSamples) const noexcept
+    {
+        jassert(delayInSamples >= 0 && delayInSamples <= maxDelay + 1);
+
+        auto frame = writePos - delayInSamples;
+
+        if (frame < 0)
+            frame += size;
+
+        return storage.data() + (size_t) (frame * numChannels);
+    }
+
+    /** Returns the next frame to be written, contiguous for getMaximumSpan() frames. Call advance() afterwards. */
+    SampleType* getWritePointer() noexcept
+    {
+        return storage.data() + (size_t) (writePos * numChannels);
+    }
+
+    /** Publishes numFrames frames written through getWritePointer() and moves the write position on. */
+    void advance(int numFrames) noexcept
+    {
+        jassert(numFrames <= maxSpan);
+
+        auto start = writePos;
+        auto end = writePos + numFrames;
+
+        // Frames that went past the end of the ring belong at its start
+        if (end > size)
+            copyFrames(size, 0, end - size);
+
+        // Frames at the start of the ring are mirrored after its end
+        if (start < mirror)
+            copyFrames(start, start + size, juce::jmin(end, mirror) - start);
+
+        writePos = end >= size ? end - size : end;
+    }
+
+private:
+    //==============================================================================
+    void copyFrames(int sourceFrame, int destFrame, int numFrames) noexcept
+    {
+        if (numFrames > 0)
+            std::memcpy(storage.data() + (size_t) (destFrame * numChannels),
+                        storage.data() + (size_t) (sourceFrame * numChannels),
+                        sizeof(SampleType) * (size_t) (numFrames * numChannels));
+    }
+
+    //==============================================================================
+    std::vector<SampleType> storage; // size + mirror interleaved frames
+    int numChannels = 0, maxDelay = 0, maxSpan = 0, mirror = 0, size = 0, writePos = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DelayRing)
+};
@@ -0,0 +1,124 @@
+/*
+  ==============================================================================
+
+    DelayTaps.h
+
+    The multi-tap table the delay kernel reads from. Every channel's lane of
+    the ring is read by the same set of taps, each at its own fraction of the
+    Delay Time, with its own level, pan and feedback routing.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/** One read head. */
+struct DelayTap
+{
+    float ratio = 1.0f;         // Delay as a fraction of the Delay Time, 0.01 to 1
+    float gain = 1.0f;          // Level in the wet output
+    float pan = 0.0f;           // 0 keeps the tap in its own channel, 1 moves it fully into the next channel round
+    float feedback = 1.0f;      // Share of the Feedback control this tap sends back into the ring
+    int feedbackTo = 0;         // Lane the feedback goes into, counted on from the tap's own (0 = same lane, 1 = next, ...)
+};
+
+//==============================================================================
+/** Up to maxTaps taps, read from every channel's lane. */
+struct TapTable
+{
+    static constexpr int maxTaps = 8;
+
+    /** The original TENNISBOY spacing - the R tap sits at 0.79 of the L tap's delay. */
+    static constexpr float classicOddChannelRatio = 0.79f;
+
+    std::array<DelayTap, maxTaps> taps;
+    int numTaps = 1;
+
+    /** Odd channels (R, ...) read every tap at this fraction of the even channels' delay. */
+    float oddChannelRatio = classicOddChannelRatio;
+
+    /** Clamps everything into range. The feedback shares are scaled down to sum to at most 1, so the loop gain never goes past the Feedback control. */
+    TapTable sanitised() const noexcept
+    {
+        auto table = *this;
+        table.numTaps = juce::jlimit(1, maxTaps, numTaps);
+        table.oddChannelRatio = juce::jlimit(0.01f, 1.0f, oddChannelRatio);
+
+        auto totalFeedback = 0.0f;
+
+        for (int t = 0; t < table.numTaps; ++t)
+        {
+            auto& tap = table.taps[(size_t) t];
+            tap.ratio = juce::jlimit(0.01f, 1.0f, tap.ratio);
+            tap.pan = juce::jlimit(0.0f, 1.0f, tap.pan);
+            tap.feedback = juce::jlimit(0.0f, 1.0f, tap.feedback);
+            tap.feedbackTo = juce::jmax(0, tap.feedbackTo);
+            totalFeedback += tap.feedback;
+        }
+
+        if (totalFeedback > 1.0f)
+            for (int t = 0; t < table.numTaps; ++t)
+                table.taps[(size_t) t].feedback /= totalFeedback;
+
+        return table;
+    }
+};
+
+//==============================================================================
+/** The built-in tables behind the "taps" parameter. */
+namespace TapPatterns
+{
+    /** In the order of the "taps" parameter's choices. */
+    inline juce::StringArray getNames()
+    {
+        return { "Classic", "Dotted", "Triplet", "Spread", "Cascade" };
+    }
+
+    /** Returns a pattern by choice index (out of range gives Classic). */
+    inline const TapTable& get(int index) noexcept
+    {
+        static const std::array<TapTable, 5> patterns = []
+        {
+            std::array<TapTable, 5> p;
+
+            // Classic - one tap at the Delay Time, 0.79 of it on the odd channels
+            p[0].taps[0] = { 1.0f, 1.0f, 0.0f, 1.0f, 0 };
+
+            // Dotted - a lighter repeat three quarters of the way in
+            p[1].numTaps = 2;
+            p[1].oddChannelRatio = 1.0f;
+            p[1].taps[0] = { 0.75f, 0.6f, 0.0f, 0.0f, 0 };
+            p[1].taps[1] = { 1.0f, 1.0f, 0.0f, 1.0f, 0 };
+
+            // Triplet - three even repeats building up to the one that feeds back
+            p[2].numTaps = 3;
+            p[2].oddChannelRatio = 1.0f;
+            p[2].taps[0] = { 1.0f / 3.0f, 0.5f, 0.0f, 0.0f, 0 };
+            p[2].taps[1] = { 2.0f / 3.0f, 0.7f, 0.0f, 0.0f, 0 };
+            p[2].taps[2] = { 1.0f, 1.0f, 0.0f, 1.0f, 0 };
+
+            // Spread - quarter notes bouncing between neighbouring channels, feeding the next channel round
+            p[3].numTaps = 4;
+            p[3].oddChannelRatio = 1.0f;
+            p[3].taps[0] = { 0.25f, 0.7f, 0.0f, 0.0f, 0 };
+            p[3].taps[1] = { 0.5f, 0.7f, 1.0f, 0.0f, 0 };
+            p[3].taps[2] = { 0.75f, 0.7f, 0.0f, 0.0f, 0 };
+            p[3].taps[3] = { 1.0f, 1.0f, 1.0f, 1.0f, 1 };
+
+            // Cascade - eight evenly spaced taps fading out, alternating channels, all feeding back a little
+            p[4].numTaps = TapTable::maxTaps;
+            p[4].oddChannelRatio = 1.0f;
+
+            for (int t = 0; t < TapTable::maxTaps; ++t)
+                p[4].taps[(size_t) t] = { (float) (t + 1) / (float) TapTable::maxTaps, 1.0f - 0.1f * (float) t,
+                                          (float) (t % 2), 1.0f / (float) TapTable::maxTaps, 0 };
+
+            return p;
+        }();
+
+        return patterns[(size_t) (index >= 0 && index < (int) patterns.size() ? index : 0)];
+    }
+}
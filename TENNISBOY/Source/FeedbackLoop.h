@@ -0,0 +1,151 @@
+/*
+  ==============================================================================
+
+    FeedbackLoop.h
+
+    The tone and saturation stage inside the delay's feedback path: a low
+    pass and a soft clip applied to whatever goes back into the delay lines,
+    so each repeat comes back darker and more saturated than the last.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SimdKernels.h"
+
+//==============================================================================
+/**
+    Low pass and soft clip for the feedback of every lane of an interleaved
+    span of frames.
+
+    The filter is the same TPT state variable design as WetFilter, but it is
+    recursive along time, so it runs across the lanes instead - one frame at a
+    time, with neighbouring lanes side by side in a vector. The soft clip isn't
+    recursive, so it goes over the whole span in one flat loop. Both come from
+    SimdKernels, built for the best instruction set the CPU has.
+
+    Cutoff and Q changes glide over 20ms, with the coefficients updated once per
+    span rather than per sample - or every frame, with setCoefficientsPerFrame(),
+    for offline renders.
+
+    SampleType is float or double.
+*/
+template <typename SampleType>
+class FeedbackLoop
+{
+public:
+    /** Most lanes a FeedbackLoop can run - the same as PingPongKernel. */
+    static constexpr int maxLanes = 16;
+
+    FeedbackLoop() = default;
+
+    //==============================================================================
+    /** Picks up the sample rate and the number of interleaved lanes. Allocates nothing. */
+    void prepare(double newSampleRate, int numLanesToUse) noexcept
+    {
+        sampleRate = newSampleRate;
+        numLanes = juce::jlimit(1, maxLanes, numLanesToUse);
+
+        cutoff.reset(sampleRate, rampLengthSeconds);
+        resonance.reset(sampleRate, rampLengthSeconds);
+        reset();
+    }
+
+    /** Clears the filter state, and jumps the smoothers to their targets. */
+    void reset() noexcept
+    {
+        std::fill(s1.begin(), s1.end(), SampleType());
+        std::fill(s2.begin(), s2.end(), SampleType());
+
+        cutoff.setCurrentAndTargetValue(cutoff.getTargetValue());
+        resonance.setCurrentAndTargetValue(resonance.getTargetValue());
+        updateCoefficients(cutoff.getTargetValue(), resonance.getTargetValue());
+    }
+
+    //==============================================================================
+    /** Sets the target cutoff in Hz. Cheap to call every block - nothing happens if the value hasn't changed. */
+    void setCutoffFrequency(float newCutoffHz) noexcept
+    {
+        if (newCutoffHz != cutoff.getTargetValue())
+            cutoff.setTargetValue(newCutoffHz);
+    }
+
+    /** Sets the target resonance (Q). Cheap to call every block - nothing happens if the value hasn't changed. */
+    void setResonance(float newQ) noexcept
+    {
+        if (newQ != resonance.getTargetValue())
+            resonance.setTargetValue(newQ);
+    }
+
+    /** The filter's and soft clip's loops, for one instruction set - PingPongKernel passes on its own. Realtime safe. */
+    void setKernels(const SimdKernels::Table<SampleType>& newKernels) noexcept { kernels = &newKernels; }
+
+    /** Recalculates the coefficients every frame while the cutoff or Q glides, rather than once per span. Smoother, and dearer. */
+    void setCoefficientsPerFrame(bool shouldUpdateEveryFrame) noexcept { coefficientsPerFrame = shouldUpdateEveryFrame; }
+
+    //==============================================================================
+    /** Filters then soft clips numFrames interleaved frames of numLanes samples, in place. */
+    void process(SampleType* data, int numFrames) noexcept
+    {
+        auto perFrame = coefficientsPerFrame && (cutoff.isSmoothing() || resonance.isSmoothing());
+
+        if (perFrame)
+        {
+            for (int frame = 0; frame < numFrames; ++frame)
+            {
+                updateCoefficients(cutoff.getNextValue(), resonance.getNextValue());
+                kernels->svfLowPassLanes(data + frame * numLanes, 1, numLanes, gain, damping, normaliser, s1.data(), s2.data());
+            }
+        }
+        else
+        {
+            if (cutoff.isSmoothing() || resonance.isSmoothing())
+                updateCoefficients(cutoff.skip(numFrames), resonance.skip(numFrames));
+
+            kernels->svfLowPassLanes(data, numFrames, numLanes, gain, damping, normaliser, s1.data(), s2.data());
+        }
+
+        kernels->softClip(data, numFrames * numLanes); // softClip() on every value
+    }
+
+    //==============================================================================
+    /** tanh, near enough: a rational fit that's exact at 0 and meets +-1 with zero slope at +-3, then holds there.
+        Never more than 0.025 from tanh, costs one divide, and has no branches, so a loop of it vectorises.
+        SimdKernels::Table::softClip is the same sum, a span at a time.
+    */
+    static SampleType softClip(SampleType x) noexcept
+    {
+        x = juce::jlimit((SampleType) -3, (SampleType) 3, x);
+        auto x2 = x * x;
+        return x * ((SampleType) 27 + x2) / ((SampleType) 27 + (SampleType) 9 * x2);
+    }
+
+private:
+    //==============================================================================
+    void updateCoefficients(float cutoffHz, float q) noexcept
+    {
+        auto fc = juce::jlimit((SampleType) 1, (SampleType) (sampleRate * 0.49), (SampleType) cutoffHz);
+
+        gain = std::tan(juce::MathConstants<SampleType>::pi * fc / (SampleType) sampleRate);
+        damping = (SampleType) 1 / (SampleType) juce::jmax(q, 0.01f) + gain;
+        normaliser = (SampleType) 1 / ((SampleType) 1 + gain * damping);
+    }
+
+    //==============================================================================
+    static constexpr double rampLengthSeconds = 0.02;
+
+    double sampleRate = 44100.0;
+    int numLanes = 2;
+    bool coefficientsPerFrame = false;
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> cutoff { 600.0f };
+    juce::SmoothedValue<float> resonance { 1.0f };
+
+    SampleType gain = 0, damping = 0, normaliser = 0; // g, (1/Q + g) and 1 / (1 + g(1/Q + g)), as in WetFilter
+    std::array<SampleType, maxLanes> s1 {}, s2 {};      // Integrator states, one per lane
+
+    const SimdKernels::Table<SampleType>* kernels = &SimdKernels::getTable<SampleType>(SimdKernels::Isa::scalar);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FeedbackLoop)
+};
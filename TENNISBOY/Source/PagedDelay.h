@@ -0,0 +1,449 @@
+/*
+  ==============================================================================
+
+    PagedDelay.h
+
+    The long delay and looper: up to a minute of delay per channel, kept in
+    fixed size pages that are only allocated once a delay time that long is
+    actually asked for. Pages are allocated and zeroed on a shared background
+    thread and handed to the audio thread through a lock-free pool, so the
+    audio thread never allocates - or faults a page in.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Paged, interleaved multichannel delay line for delays too long to allocate up front.
+
+    The ring is a list of pages of pageFrames frames each. It starts just long
+    enough for the delay it was prepared with, and when a longer delay is set it
+    grows the next time the write head comes round to its end - the head carries
+    straight on into new pages instead of wrapping, so nothing already recorded
+    moves. Until then the delay is held at the longest the ring can give. The
+    ring never shrinks; its pages are freed on the next prepare().
+
+    A page only goes into the ring (is committed) when the write head first
+    reaches it, taken from a pool of pre-zeroed pages the background thread
+    keeps topped up to what the ring needs, plus a small reserve. If the pool
+    ever runs dry the head skips that stretch of the page and tries again on
+    the next block; reads of a missing page are silence.
+
+    The reserve is there for a delay that's just been switched on: until then
+    nothing has asked for pages, and the background thread only looks in every
+    idleIntervalMs. Enough pages to record that long are kept in hand, so the
+    first thing played after the switch is never lost.
+
+    One tap per channel at a whole-sample delay, fed back into its own lane -
+    or the next one round with rotate set. A change of delay crossfades between
+    the old and new read heads rather than gliding. Frozen, the input and the
+    feedback are ignored and whatever the ring holds loops at the current delay.
+
+    With a latency compensation set, the output is read that many frames early
+    while the feedback and the frozen loop still read at the full delay - as in
+    PingPongKernel, only the first pass makes up for a late input.
+
+    SampleType is float or double.
+*/
+template <typename SampleType>
+class PagedDelay  : private juce::TimeSliceClient
+{
+public:
+    /** Most channels a PagedDelay can run - the same as PingPongKernel. */
+    static constexpr int maxChannels = 16;
+
+    /** Frames per page - a power of two. About 190ms at 44.1kHz. */
+    static constexpr int pageFrames = 1 << 13;
+
+    PagedDelay() = default;
+
+    ~PagedDelay() override
+    {
+        stopAllocating();
+    }
+
+    //==============================================================================
+    /** Frees every page and sets up an empty ring. Not realtime safe.
+
+        Nothing is allocated for the audio unless initialDelayInSamples is more than 0 - then the pages
+        for that delay are allocated here, so the first block doesn't have to wait for the background thread -
+        or reserveFrames is, when enough pages to record that many frames are allocated straight away and kept
+        in the pool from then on (see getReserveFrames).
+        With allocateInBackground false there's no background thread at all, and pages only come from calling
+        allocatePages() - for tests that need to know exactly when they arrive.
+    */
+    void prepare(int numChannelsToUse, int maximumDelayInSamples, int initialDelayInSamples, int reserveFrames = 0,
+                 bool allocateInBackground = true)
+    {
+        jassert(numChannelsToUse > 0 && numChannelsToUse <= maxChannels);
+
+        stopAllocating();
+
+        numChannels = juce::jlimit(1, maxChannels, numChannelsToUse);
+        maxDelay = juce::jmax(1, maximumDelayInSamples);
+        maxPages = getPagesFor(maxDelay);
+        reservePages = reserveFrames > 0 ? (reserveFrames + pageFrames - 1) / pageFrames + 1 : 0; // The head can be anywhere in the first one
+
+        {
+            const juce::ScopedLock sl(allocatorLock);
+            allocatedPages.clear();
+            allocatedPages.reserve((size_t) maxPages);
+        }
+
+        pageTable.assign((size_t) maxPages, nullptr);
+        stalePages.assign((size_t) maxPages, 0);
+        poolSlots.assign((size_t) maxPages + 1, nullptr);
+        pool.setTotalSize(maxPages + 1);
+        pool.reset();
+        numCommittedPages = 0;
+
+        delay = targetDelay = juce::jlimit(1, maxDelay, initialDelayInSamples);
+        numRingPages = getPagesFor(delay);
+        wantedPages = initialDelayInSamples > 0 ? numRingPages : 0;
+        writePosition = 0;
+        fadeLength = fadePosition = 0;
+        framesSinceAudibleWrite = getRingFrames() + 1;
+
+        allocatePages();
+
+        if (allocateInBackground)
+        {
+            allocatorThread = std::make_unique<juce::SharedResourcePointer<AllocatorThread>>();
+            (*allocatorThread)->addTimeSliceClient(this);
+        }
+    }
+
+    /** Frees every page and stops the background allocation until the next prepare() - process() mustn't be called in between.
+        Not realtime safe.
+    */
+    void release()
+    {
+        stopAllocating();
+
+        {
+            const juce::ScopedLock sl(allocatorLock);
+            allocatedPages = {};
+        }
+
+        pageTable = {};
+        stalePages = {};
+        poolSlots = {};
+        pool.setTotalSize(1);
+        pool.reset();
+        numCommittedPages = 0;
+        maxPages = 0;
+        numRingPages = 1;
+        wantedPages = 0;
+        reservePages = 0;
+    }
+
+    /** Silences the ring, as if nothing had ever been written to it. Realtime safe - the committed pages are only marked stale here.
+        A stale page reads as silence, and is cleared when the write head next comes to it.
+    */
+    void reset() noexcept
+    {
+        for (size_t page = 0; page < pageTable.size(); ++page)
+            stalePages[page] = pageTable[page] != nullptr ? 1 : 0;
+
+        fadeLength = fadePosition = 0;
+        framesSinceAudibleWrite = getRingFrames() + 1;
+    }
+
+    //==============================================================================
+    int getNumChannels() const noexcept                 { return numChannels; }
+    int getMaximumDelayInSamples() const noexcept       { return maxDelay; }
+
+    /** Pages in the ring so far - what the delay is actually using. Any thread. */
+    int getNumCommittedPages() const noexcept           { return numCommittedPages.load(std::memory_order_relaxed); }
+
+    /** Bytes of delay memory in use, allocated or committed. Any thread. */
+    size_t getAllocatedBytes() const
+    {
+        const juce::ScopedLock sl(allocatorLock);
+        return allocatedPages.size() * (size_t) (pageFrames * numChannels) * sizeof(SampleType);
+    }
+
+    /** True once nothing above silenceThreshold is left anywhere in the ring. */
+    bool isSilent() const noexcept { return framesSinceAudibleWrite > getRingFrames(); }
+
+    /** Level (about -100dB) below which anything written counts as silence - the same as PingPongKernel. */
+    static constexpr float silenceThreshold = 1.0e-5f;
+
+    /** The reserve prepare() should be given at a sample rate: enough to record for as long as the background thread can take to
+        notice the first setDelay() after a while without.
+    */
+    static int getReserveFrames(double sampleRate) noexcept { return (int) std::ceil(idleIntervalMs * sampleRate / 1000.0); }
+
+    //==============================================================================
+    /** Sets the delay in samples. A change crossfades from the old read head over crossfadeLength samples - or, if a crossfade is
+        still running, waits for it to finish and then crossfades to the latest delay set. Realtime safe.
+
+        The background thread starts allocating any pages a longer delay needs within busyIntervalMs - or idleIntervalMs, the
+        first time it's called after a while without.
+    */
+    void setDelay(int delayInSamples, int crossfadeLength) noexcept
+    {
+        targetDelay = juce::jlimit(1, maxDelay, delayInSamples);
+        targetFadeLength = juce::jmax(1, crossfadeLength);
+        wantedPages.store(juce::jmax(numRingPages, getPagesFor(targetDelay)), std::memory_order_relaxed);
+        inUse.store(true, std::memory_order_relaxed); // The allocator keeps looking in often while this is being called - see useTimeSlice()
+    }
+
+    /** Reads the output this many frames before the delay, to make up for an input that arrives late. The feedback and a frozen
+        loop still read at the full delay. Realtime safe.
+    */
+    void setLatencyCompensation(int frames) noexcept { latencyCompensation = juce::jmax(0, frames); }
+
+    /** Runs the delay over a block of planar channels in place, with constant feedback and wet gain. */
+    void process(SampleType* const* channels, int numSamples, float feedback, float wetGain, bool rotate, bool freeze) noexcept
+    {
+        processFrames(channels, numSamples, rotate, freeze, [feedback] (int) { return feedback; }, [wetGain] (int) { return wetGain; });
+    }
+
+    /** Runs the delay over a block of planar channels in place, with per-sample feedback and wet gain. */
+    void process(SampleType* const* channels, int numSamples, const float* feedback, const float* wetGain, bool rotate, bool freeze) noexcept
+    {
+        processFrames(channels, numSamples, rotate, freeze, [feedback] (int i) { return feedback[i]; }, [wetGain] (int i) { return wetGain[i]; });
+    }
+
+    //==============================================================================
+    /** Allocates zeroed pages into the pool until it holds everything the ring still needs, and the reserve. Never call it on the audio thread.
+
+        The background thread calls this; it's public so a caller that can't wait for it (a test, say) can call it directly.
+    */
+    void allocatePages()
+    {
+        const juce::ScopedLock sl(allocatorLock);
+        auto wanted = juce::jmin(maxPages, wantedPages.load(std::memory_order_relaxed) + reservePages);
+
+        while ((int) allocatedPages.size() < wanted && pool.getFreeSpace() > 0)
+        {
+            // The OS only backs memory once it's touched, and that page fault mustn't be left to the audio thread's first write. The
+            // volatile writes make sure the compiler can't turn the zeroing back into a calloc that leaves it untouched
+            allocatedPages.emplace_back((size_t) (pageFrames * numChannels));
+            auto* page = allocatedPages.back().get();
+            std::fill(page, page + pageFrames * numChannels, SampleType());
+
+            for (int i = 0; i < pageFrames * numChannels; i += touchStride)
+                static_cast<volatile SampleType*>(page)[i] = SampleType();
+
+            int start1, size1, start2, size2;
+            pool.prepareToWrite(1, start1, size1, start2, size2);
+            poolSlots[(size_t) start1] = allocatedPages.back().get();
+            pool.finishedWrite(size1);
+        }
+    }
+
+private:
+    //==============================================================================
+    /** One thread shared by every instance, topping up their page pools. */
+    struct AllocatorThread  : public juce::TimeSliceThread
+    {
+        AllocatorThread() : juce::TimeSliceThread("TableTennis page allocator") { startThread(); }
+        ~AllocatorThread() override { stopThread(1000); }
+    };
+
+    /** While the delay is running it's given a delay every block, and can ask for pages any time - a page lasts about 40ms even at
+        192kHz, and the pool is filled a whole delay ahead. Switched off, it can't want anything new, so the thread hardly ever wakes for it.
+    */
+    static constexpr int busyIntervalMs = 20, idleIntervalMs = 250;
+
+    int useTimeSlice() override
+    {
+        allocatePages();
+        return inUse.exchange(false, std::memory_order_relaxed) ? busyIntervalMs : idleIntervalMs;
+    }
+
+    void stopAllocating()
+    {
+        if (allocatorThread != nullptr)
+            (*allocatorThread)->removeTimeSliceClient(this); // Waits for a slice in progress to finish
+
+        allocatorThread.reset();
+    }
+
+    //==============================================================================
+    static int getPagesFor(int delayInSamples) noexcept { return delayInSamples / pageFrames + 1; } // The ring has to be at least a frame longer than the delay
+    int getRingFrames() const noexcept                  { return numRingPages * pageFrames; }
+
+    int wrap(int position) const noexcept { return position < 0 ? position + getRingFrames() : position; }
+
+    /** The page the write head is in, committing one from the pool if it hasn't got one yet. nullptr if the pool is empty. */
+    SampleType* commitPage(int page) noexcept
+    {
+        auto*& entry = pageTable[(size_t) page];
+
+        if (stalePages[(size_t) page] != 0)
+        {
+            std::fill(entry, entry + pageFrames * numChannels, SampleType()); // Still holds what was there before a reset()
+            stalePages[(size_t) page] = 0;
+        }
+        else if (entry == nullptr)
+        {
+            int start1, size1, start2, size2;
+            pool.prepareToRead(1, start1, size1, start2, size2);
+
+            if (size1 > 0)
+            {
+                entry = poolSlots[(size_t) start1];
+                numCommittedPages.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            pool.finishedRead(size1);
+        }
+
+        return entry;
+    }
+
+    /** At the end of the ring: grows into new pages if a longer delay is waiting, otherwise wraps. Then moves the read head if the delay
+        changed and no crossfade is running.
+    */
+    void updateHeads() noexcept
+    {
+        if (writePosition == getRingFrames())
+        {
+            auto pagesWanted = juce::jmin(maxPages, getPagesFor(targetDelay));
+
+            if (pagesWanted > numRingPages)
+                numRingPages = pagesWanted;
+            else
+                writePosition = 0;
+        }
+
+        auto newDelay = juce::jmin(targetDelay, getRingFrames() - 1);
+
+        if (newDelay != delay && fadePosition >= fadeLength) // Runs stop where a fade ends, so the next one starts on the very next frame
+        {
+            fadeFromDelay = delay;
+            delay = newDelay;
+            fadeLength = targetFadeLength;
+            fadePosition = 0;
+        }
+    }
+
+    template <typename FeedbackAt, typename WetGainAt>
+    void processFrames(SampleType* const* channels, int numSamples, bool rotate, bool freeze,
+                       FeedbackAt feedbackAt, WetGainAt wetGainAt) noexcept
+    {
+        constexpr int pageMask = pageFrames - 1;
+
+        for (int start = 0; start < numSamples;)
+        {
+            updateHeads();
+
+            // Runs stop at the end of every page any head is in, so everything inside one is a straight walk
+            auto fading = fadePosition < fadeLength;
+            auto compensating = latencyCompensation > 0;
+            auto numFrames = juce::jmin(numSamples - start, pageFrames - (writePosition & pageMask));
+
+            if (fading)
+                numFrames = juce::jmin(numFrames, fadeLength - fadePosition);
+
+            auto readAt = [this, &numFrames] (int headDelay) -> const SampleType*
+            {
+                auto position = wrap(writePosition - headDelay);
+                numFrames = juce::jmin(numFrames, pageFrames - (position & pageMask));
+                auto* page = stalePages[(size_t) (position / pageFrames)] != 0 ? nullptr : pageTable[(size_t) (position / pageFrames)];
+                return page != nullptr ? page + (position & pageMask) * numChannels : nullptr;
+            };
+
+            auto* src = readAt(juce::jmax(1, delay - latencyCompensation));
+            auto* feedbackSrc = compensating ? readAt(delay) : src;
+            auto* fadeSrc = fading ? readAt(juce::jmax(1, fadeFromDelay - latencyCompensation)) : nullptr;
+            auto* fadeFeedbackSrc = fading && compensating ? readAt(fadeFromDelay) : fadeSrc;
+            auto* dest = commitPage(writePosition / pageFrames);
+
+            if (dest != nullptr)
+                dest += (writePosition & pageMask) * numChannels;
+
+            auto loudest = SampleType();
+
+            for (int i = 0; i < numFrames; ++i)
+            {
+                SampleType wet[maxChannels], fed[maxChannels];
+                auto fadeIn = fading ? (SampleType) ((float) (fadePosition + i + 1) / (float) fadeLength) : SampleType();
+
+                // One frame from a head, crossfaded from the old one while fading - a missing page reads as silence
+                auto readFrame = [&] (const SampleType* head, const SampleType* fadeHead, SampleType* out)
+                {
+                    for (int channel = 0; channel < numChannels; ++channel)
+                    {
+                        out[channel] = head != nullptr ? head[i * numChannels + channel] : SampleType();
+
+                        if (fading)
+                        {
+                            auto old = fadeHead != nullptr ? fadeHead[i * numChannels + channel] : SampleType();
+                            out[channel] = old + fadeIn * (out[channel] - old);
+                        }
+                    }
+                };
+
+                readFrame(src, fadeSrc, wet);
+
+                if (compensating)
+                    readFrame(feedbackSrc, fadeFeedbackSrc, fed);
+                else
+                    std::copy(wet, wet + numChannels, fed);
+
+                auto feedback = (SampleType) feedbackAt(start + i);
+                auto wetGain = (SampleType) wetGainAt(start + i);
+
+                for (int channel = 0; channel < numChannels; ++channel)
+                {
+                    auto& io = channels[channel][start + i];
+
+                    // Frozen, the ring just plays itself back; otherwise the input goes in with the feedback from this lane (or the one before, rotating)
+                    auto written = freeze ? fed[channel] : io + feedback * fed[rotate ? (channel + numChannels - 1) % numChannels : channel];
+
+                    if (dest != nullptr)
+                        dest[i * numChannels + channel] = written;
+
+                    loudest = juce::jmax(loudest, std::abs(written));
+                    io = wet[channel] * wetGain;
+                }
+            }
+
+            if (loudest > (SampleType) silenceThreshold)
+                framesSinceAudibleWrite = 0;
+            else if (framesSinceAudibleWrite <= getRingFrames())
+                framesSinceAudibleWrite += numFrames;
+
+            if (fading)
+                fadePosition += numFrames;
+
+            writePosition += numFrames;
+            start += numFrames;
+        }
+    }
+
+    //==============================================================================
+    static constexpr int touchStride = 4096 / (int) sizeof(SampleType); // One write per 4KB, the smallest page the OS hands out
+
+    int numChannels = 2, maxDelay = 1, maxPages = 1;
+    int reservePages = 0; // Kept in the pool over what the ring wants
+
+    // Audio thread only, after prepare()
+    std::vector<SampleType*> pageTable; // Every page the ring could ever use, nullptr until committed
+    std::vector<char> stalePages; // Set for a committed page that's silent since a reset(), until the write head clears it
+    int numRingPages = 1, writePosition = 0;
+    int delay = 1, targetDelay = 1, targetFadeLength = 1;
+    int fadeFromDelay = 0, fadeLength = 0, fadePosition = 0; // Not crossfading once fadePosition reaches fadeLength
+    int latencyCompensation = 0; // Frames the output reads early
+    int framesSinceAudibleWrite = 0;
+
+    // The pool - filled by the allocator thread, emptied by the audio thread
+    juce::AbstractFifo pool { 1 };
+    std::vector<SampleType*> poolSlots;
+    std::atomic<int> wantedPages { 0 }, numCommittedPages { 0 };
+
+    juce::CriticalSection allocatorLock; // Only ever taken off the audio thread
+    std::vector<juce::HeapBlock<SampleType>> allocatedPages; // Owns every page, in the pool or the ring
+    std::unique_ptr<juce::SharedResourcePointer<AllocatorThread>> allocatorThread; // Only created once prepared, and seldom woken while setDelay() isn't being called
+    std::atomic<bool> inUse { false }; // Set by setDelay(), cleared by every time slice
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PagedDelay)
+};
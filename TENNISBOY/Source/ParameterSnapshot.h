@@ -0,0 +1,270 @@
+/*
+  ==============================================================================
+
+    ParameterSnapshot.h
+
+    The audio thread's view of the parameters. Every parameter is loaded
+    atomically once at the start of a block into a ParameterSnapshot, and
+    ParameterRamps turns the snapshot into per-sample smoothed values for the
+    delay core, so nothing the message thread does can change a value halfway
+    through a block.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "DelayInterpolation.h"
+#include "TempoSync.h"
+
+//==============================================================================
+/** All parameter values for one block, in the parameters' own units. */
+struct ParameterSnapshot
+{
+    float delayTimeMs = 1000.0f;
+    float feedback = 0.3f;
+    float wetDry = 0.3f;
+    float lpf = 600.0f;
+    float q = 1.0f;
+    DelayInterpolation::Quality quality = DelayInterpolation::Quality::linear;
+    bool rotate = false; // Ping-pong - repeats move one channel on
+    int tapPattern = 0;  // Index into TapPatterns
+    bool loopFilter = false; // Low pass and soft clip inside the feedback loop instead of on the input
+    float wow = 0.0f;        // Slow tape wobble, 0 to 1 of WowFlutter's full depth
+    float flutter = 0.0f;    // Fast tape wobble, 0 to 1
+    int oversampling = 0;    // Input LPF oversampling, as a power of two - 0 off, 1 2x, 2 4x
+    bool longDelay = false;  // The paged long delay (see PagedDelay) instead of the multi-tap kernel
+    float longTimeSeconds = 8.0f; // Its delay time
+    bool freeze = false;     // Long delay only - loop what's in it, ignoring the input and the feedback
+    bool sync = false;       // Delay time from the host tempo and division - see TableTennisAudioProcessor::resolveTempo
+    int division = TempoSync::defaultDivision; // Index into TempoSync::getDivisions()
+    TempoSync::Transition transition = TempoSync::Transition::glide; // How the delay moves to a new time
+
+    //==============================================================================
+    /** Every field as a float, in this order. It's the order the saved state uses, so only ever append to it. */
+    static constexpr int numValues = 18;
+
+    /** The parameter behind each value. */
+    static constexpr const char* parameterIDs[numValues] = { "delayTime", "feedback", "wetDry", "lpf", "Q", "quality", "pingPong", "taps", "loopFilter", "wow", "flutter", "oversampling",
+                                                               "longDelay", "longTime", "freeze", "sync", "division", "transition" };
+
+    std::array<float, numValues> toValues() const noexcept
+    {
+        return { delayTimeMs, feedback, wetDry, lpf, q, (float) quality, rotate ? 1.0f : 0.0f, (float) tapPattern,
+                 loopFilter ? 1.0f : 0.0f, wow, flutter, (float) oversampling, longDelay ? 1.0f : 0.0f, longTimeSeconds, freeze ? 1.0f : 0.0f,
+                 sync ? 1.0f : 0.0f, (float) division, (float) transition };
+    }
+
+    static ParameterSnapshot fromValues(const std::array<float, numValues>& values) noexcept
+    {
+        ParameterSnapshot snapshot;
+        snapshot.delayTimeMs = values[0];
+        snapshot.feedback = values[1];
+        snapshot.wetDry = values[2];
+        snapshot.lpf = values[3];
+        snapshot.q = values[4];
+        snapshot.quality = (DelayInterpolation::Quality) juce::roundToInt(values[5]);
+        snapshot.rotate = values[6] >= 0.5f;
+        snapshot.tapPattern = juce::roundToInt(values[7]);
+        snapshot.loopFilter = values[8] >= 0.5f;
+        snapshot.wow = values[9];
+        snapshot.flutter = values[10];
+        snapshot.oversampling = juce::roundToInt(values[11]);
+        snapshot.longDelay = values[12] >= 0.5f;
+        snapshot.longTimeSeconds = values[13];
+        snapshot.freeze = values[14] >= 0.5f;
+        snapshot.sync = values[15] >= 0.5f;
+        snapshot.division = juce::roundToInt(values[16]);
+        snapshot.transition = (TempoSync::Transition) juce::roundToInt(values[17]);
+        return snapshot;
+    }
+
+    /** The point proportion (0 to 1) of the way from one snapshot to another. Continuous values move - the cutoff
+        along a log scale, as the lpf knob does - and switches and choices take the 'to' values straight away. So do
+        the long delay time, which crossfades to a new value rather than gliding, and the delay time when it's set
+        to crossfade too.
+        Equal snapshots give that snapshot back exactly.
+    */
+    static ParameterSnapshot interpolate(const ParameterSnapshot& from, const ParameterSnapshot& to, float proportion) noexcept
+    {
+        auto lerp = [proportion] (float a, float b) { return a + (b - a) * proportion; };
+
+        auto snapshot = to;
+        snapshot.delayTimeMs = to.transition == TempoSync::Transition::crossfade ? to.delayTimeMs : lerp(from.delayTimeMs, to.delayTimeMs);
+        snapshot.feedback = lerp(from.feedback, to.feedback);
+        snapshot.wetDry = lerp(from.wetDry, to.wetDry);
+        snapshot.lpf = from.lpf > 0.0f && to.lpf > 0.0f ? from.lpf * std::pow(to.lpf / from.lpf, proportion) : to.lpf;
+        snapshot.q = lerp(from.q, to.q);
+        snapshot.wow = lerp(from.wow, to.wow);
+        snapshot.flutter = lerp(from.flutter, to.flutter);
+        return snapshot;
+    }
+};
+
+//==============================================================================
+/** Equal power wet/dry crossfade gains. */
+struct MixGains
+{
+    float wet = 0.0f, dry = 1.0f;
+
+    /** Exact gains - for once-per-block use. */
+    static MixGains fromMix(float mix) noexcept
+    {
+        auto angle = mix * juce::MathConstants<float>::halfPi;
+        return { std::sin(angle), std::cos(angle) };
+    }
+
+    /** Table lookup - cheap enough for every sample while the mix is ramping. */
+    static MixGains fromMixTable(float mix) noexcept
+    {
+        auto& table = getQuarterSineTable();
+        return { table.processSampleUnchecked(mix), table.processSampleUnchecked(1.0f - mix) };
+    }
+
+private:
+    /** sin(x * pi/2) for x in [0, 1], shared by every instance. */
+    static const juce::dsp::LookupTableTransform<float>& getQuarterSineTable()
+    {
+        static const juce::dsp::LookupTableTransform<float> table([] (float x) { return std::sin(x * juce::MathConstants<float>::halfPi); },
+                                                                   0.0f, 1.0f, 256);
+        return table;
+    }
+};
+
+//==============================================================================
+/**
+    Smoothed feedback, mix and delay time for the ping-pong kernel.
+
+    setTargets() is called once per block with the block's snapshot. While any
+    value is still ramping, fill() writes per-sample values for a slice of the
+    block into preallocated arrays. Once everything has settled the kernel runs
+    on the constant values and no per-sample work is done at all.
+*/
+class ParameterRamps
+{
+public:
+    enum Ramp
+    {
+        delay = 0,      // Samples - the taps read at their own fractions of this
+        feedback,
+        wetGain,
+        dryGain,
+        numRamps
+    };
+
+    ParameterRamps() = default;
+
+    //==============================================================================
+    /** Allocates the per-sample arrays. Not realtime safe. */
+    void prepare(double newSampleRate, int maximumBlockSize)
+    {
+        sampleRate = newSampleRate;
+        ramps.setSize(numRamps, juce::jmax(1, maximumBlockSize));
+
+        delaySamples.reset(sampleRate, delayRampSeconds);
+        feedbackValue.reset(sampleRate, gainRampSeconds);
+        mixValue.reset(sampleRate, gainRampSeconds);
+
+        MixGains::fromMixTable(0.0f); // Builds the shared table here, rather than on the audio thread the first time the mix moves
+    }
+
+    /** Jumps straight to the snapshot's values. */
+    void reset(const ParameterSnapshot& snapshot) noexcept
+    {
+        delaySamples.setCurrentAndTargetValue(toSamples(snapshot.delayTimeMs));
+        feedbackValue.setCurrentAndTargetValue(snapshot.feedback);
+        mixValue.setCurrentAndTargetValue(snapshot.wetDry);
+        updateConstants();
+    }
+
+    /** Jumps the delay time straight to the snapshot's, with no ramp, and returns the delay (in samples) it was at.
+        The caller crossfades between the two instead - see PingPongKernel::startCrossfade.
+    */
+    float jumpDelay(const ParameterSnapshot& snapshot) noexcept
+    {
+        auto previous = delaySamples.getCurrentValue();
+        delaySamples.setCurrentAndTargetValue(toSamples(snapshot.delayTimeMs));
+
+        if (! isSmoothing())
+            updateConstants();
+
+        return previous;
+    }
+
+    /** Starts ramping towards this block's values. */
+    void setTargets(const ParameterSnapshot& snapshot) noexcept
+    {
+        delaySamples.setTargetValue(toSamples(snapshot.delayTimeMs));
+        feedbackValue.setTargetValue(snapshot.feedback);
+        mixValue.setTargetValue(snapshot.wetDry);
+
+        if (! isSmoothing())
+            updateConstants();
+    }
+
+    //==============================================================================
+    bool isSmoothing() const noexcept
+    {
+        return delaySamples.isSmoothing() || feedbackValue.isSmoothing() || mixValue.isSmoothing();
+    }
+
+    /** Longest slice fill() can handle in one go. */
+    int getMaximumBlockSize() const noexcept { return ramps.getNumSamples(); }
+
+    /** Writes numSamples of per-sample values and steps the smoothers on. */
+    void fill(int numSamples) noexcept
+    {
+        jassert(numSamples <= ramps.getNumSamples());
+
+        auto* dl = ramps.getWritePointer(delay);
+        auto* fb = ramps.getWritePointer(feedback);
+        auto* wet = ramps.getWritePointer(wetGain);
+        auto* dry = ramps.getWritePointer(dryGain);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            dl[i] = delaySamples.getNextValue();
+            fb[i] = feedbackValue.getNextValue();
+
+            auto gains = MixGains::fromMixTable(mixValue.getNextValue());
+            wet[i] = gains.wet;
+            dry[i] = gains.dry;
+        }
+
+        if (! isSmoothing())
+            updateConstants();
+    }
+
+    const float* get(Ramp ramp) const noexcept { return ramps.getReadPointer(ramp); }
+
+    //==============================================================================
+    /** Settled values, valid whenever isSmoothing() is false. */
+    float getDelay() const noexcept         { return constantDelay; }
+    float getFeedback() const noexcept      { return feedbackValue.getTargetValue(); }
+    MixGains getMixGains() const noexcept   { return constantGains; }
+
+private:
+    //==============================================================================
+    float toSamples(float milliseconds) const noexcept { return (float) (milliseconds * sampleRate / 1000.0); }
+
+    void updateConstants() noexcept
+    {
+        constantDelay = delaySamples.getTargetValue();
+        constantGains = MixGains::fromMix(mixValue.getTargetValue()); // Once per block, not per sample
+    }
+
+    //==============================================================================
+    static constexpr double delayRampSeconds = 0.1;
+    static constexpr double gainRampSeconds = 0.02;
+
+    double sampleRate = 44100.0;
+    juce::SmoothedValue<float> delaySamples { 44100.0f }, feedbackValue { 0.3f }, mixValue { 0.3f };
+
+    float constantDelay = 44100.0f;
+    MixGains constantGains = MixGains::fromMix(0.3f);
+
+    juce::AudioBuffer<float> ramps; // One channel per Ramp
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ParameterRamps)
+};
@@ -0,0 +1,154 @@
+/*
+  ==============================================================================
+
+    PerformanceMonitor.cpp
+
+  ==============================================================================
+*/
+
+#include "PerformanceMonitor.h"
+
+//==============================================================================
+PerformanceMonitor::PerformanceMonitor()
+    : nanosecondsPerTick(1.0e9 / (double) juce::Time::getHighResolutionTicksPerSecond())
+{
+}
+
+void PerformanceMonitor::addBlock(juce::int64 ticks, int numSamples, double sampleRate) noexcept
+{
+    BlockTiming timing;
+    timing.nanoseconds = (juce::int64) ((double) ticks * nanosecondsPerTick);
+    timing.numSamples = numSamples;
+    timing.sampleRate = sampleRate;
+
+    if (timing.getLoad() > 1.0)
+        overruns.fetch_add(1, std::memory_order_relaxed);
+
+    auto* data = fifoData.load(std::memory_order_acquire);
+
+    if (data == nullptr)
+        return; // Never been read, so there's no FIFO yet
+
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(1, start1, size1, start2, size2);
+
+    if (size1 + size2 == 0)
+    {
+        dropped.fetch_add(1, std::memory_order_relaxed); // Nobody's reading (editor closed) - just lose the record
+        return;
+    }
+
+    data[size1 > 0 ? start1 : start2] = timing;
+    fifo.finishedWrite(1);
+}
+
+//==============================================================================
+void PerformanceMonitor::update()
+{
+    if (fifoStorage == nullptr)
+    {
+        //First read - nothing's been recorded yet, so allocate somewhere for the audio thread to start recording to
+        history.resize((size_t) historySize);
+        sortScratch.resize((size_t) historySize);
+        fifoStorage = std::make_unique<BlockTiming[]>((size_t) fifoSize);
+        fifoData.store(fifoStorage.get(), std::memory_order_release);
+        return;
+    }
+
+    int start1, size1, start2, size2;
+    fifo.prepareToRead(fifo.getNumReady(), start1, size1, start2, size2);
+
+    auto append = [this] (const BlockTiming& timing)
+    {
+        auto index = (historyStart + historyCount) % historySize;
+        history[(size_t) index] = timing;
+
+        if (historyCount < historySize)
+            ++historyCount;
+        else
+            historyStart = (historyStart + 1) % historySize; // Full - the oldest record falls off
+    };
+
+    for (int i = 0; i < size1; ++i)
+        append(fifoStorage[(size_t) (start1 + i)]);
+
+    for (int i = 0; i < size2; ++i)
+        append(fifoStorage[(size_t) (start2 + i)]);
+
+    fifo.finishedRead(size1 + size2);
+}
+
+void PerformanceMonitor::reset()
+{
+    //Reading is the consumer's side of the FIFO, so skipping past what's queued is safe while the audio thread writes
+    if (fifoStorage != nullptr)
+        fifo.finishedRead(fifo.getNumReady());
+
+    historyStart = 0;
+    historyCount = 0;
+}
+
+PerformanceMonitor::Stats PerformanceMonitor::getStats() const
+{
+    Stats stats;
+    stats.overruns = overruns.load(std::memory_order_relaxed);
+    stats.dropped = dropped.load(std::memory_order_relaxed);
+    stats.numBlocks = historyCount;
+
+    if (historyCount == 0)
+        return stats;
+
+    double loadSum = 0.0, nanosecondsSum = 0.0;
+    juce::int64 samplesSum = 0;
+    stats.minLoad = std::numeric_limits<double>::max();
+
+    for (int i = 0; i < historyCount; ++i)
+    {
+        auto& timing = history[(size_t) ((historyStart + i) % historySize)];
+        auto load = timing.getLoad();
+
+        sortScratch[(size_t) i] = load;
+        stats.minLoad = juce::jmin(stats.minLoad, load);
+        loadSum += load;
+        nanosecondsSum += (double) timing.nanoseconds;
+        samplesSum += timing.numSamples;
+    }
+
+    auto& last = history[(size_t) ((historyStart + historyCount - 1) % historySize)];
+    stats.lastBlockSize = last.numSamples;
+    stats.lastSampleRate = last.sampleRate;
+    stats.meanLoad = loadSum / historyCount;
+    stats.meanNanosecondsPerSample = samplesSum > 0 ? nanosecondsSum / (double) samplesSum : 0.0;
+
+    // 99th percentile - nth_element works in place on the preallocated scratch array
+    auto p99Index = juce::jmin(historyCount - 1, (int) std::ceil(0.99 * historyCount) - 1);
+    std::nth_element(sortScratch.begin(), sortScratch.begin() + p99Index, sortScratch.begin() + historyCount);
+    stats.p99Load = sortScratch[(size_t) p99Index];
+
+    return stats;
+}
+
+bool PerformanceMonitor::writeCSV(const juce::File& file) const
+{
+    juce::FileOutputStream stream(file);
+
+    if (! stream.openedOk())
+        return false;
+
+    stream.setPosition(0);
+    stream.truncate();
+    stream << "block,nanoseconds,samples,sample_rate,ns_per_sample,load\n";
+
+    for (int i = 0; i < historyCount; ++i)
+    {
+        auto& timing = history[(size_t) ((historyStart + i) % historySize)];
+        stream << i << ","
+               << timing.nanoseconds << ","
+               << timing.numSamples << ","
+               << timing.sampleRate << ","
+               << juce::String(timing.getNanosecondsPerSample(), 2) << ","
+               << juce::String(timing.getLoad(), 5) << "\n";
+    }
+
+    return true;
+}
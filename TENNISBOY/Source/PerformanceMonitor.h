@@ -0,0 +1,124 @@
+/*
+  ==============================================================================
+
+    PerformanceMonitor.h
+
+    Lock-free timing of processBlock. The audio thread pushes one record per
+    block into a wait-free single producer/single consumer FIFO, and the
+    editor drains it on the message thread to show a CPU meter.
+
+    The FIFO and the history behind it are only allocated the first time
+    they're read, so an instance whose editor is never opened - most of them,
+    in a big session - doesn't carry them.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Per-block processBlock timings.
+
+    Audio thread: ScopedBlockTimer (or addBlock) only - no locks, no allocation.
+    Message thread: update(), reset(), getStats() and writeCSV().
+*/
+class PerformanceMonitor
+{
+public:
+    /** One processBlock call. */
+    struct BlockTiming
+    {
+        juce::int64 nanoseconds = 0; // Wall time spent in processBlock
+        int numSamples = 0;
+        double sampleRate = 0.0;
+
+        double getNanosecondsPerSample() const noexcept { return numSamples > 0 ? (double) nanoseconds / numSamples : 0.0; }
+
+        /** Fraction of the block's real-time deadline that was used - above 1 is an overrun. */
+        double getLoad() const noexcept
+        {
+            return numSamples > 0 && sampleRate > 0.0 ? (double) nanoseconds * sampleRate / (1.0e9 * numSamples) : 0.0;
+        }
+    };
+
+    /** Rolling figures over the blocks currently in the history. */
+    struct Stats
+    {
+        int numBlocks = 0;
+        double minLoad = 0.0, meanLoad = 0.0, p99Load = 0.0; // Fractions of the block deadline
+        double meanNanosecondsPerSample = 0.0;
+        int lastBlockSize = 0;
+        double lastSampleRate = 0.0;
+        juce::uint32 overruns = 0;                           // Since the plugin was created
+        juce::uint32 dropped = 0;                            // Records lost because the FIFO was full
+    };
+
+    PerformanceMonitor();
+
+    //==============================================================================
+    /** Times the enclosing scope and records it as one block. Audio thread only. */
+    class ScopedBlockTimer
+    {
+    public:
+        ScopedBlockTimer(PerformanceMonitor& monitorToUse, int numSamplesInBlock, double currentSampleRate) noexcept
+            : monitor(monitorToUse), numSamples(numSamplesInBlock), sampleRate(currentSampleRate),
+              start(juce::Time::getHighResolutionTicks())
+        {
+        }
+
+        ~ScopedBlockTimer() noexcept
+        {
+            monitor.addBlock(juce::Time::getHighResolutionTicks() - start, numSamples, sampleRate);
+        }
+
+    private:
+        PerformanceMonitor& monitor;
+        int numSamples;
+        double sampleRate;
+        juce::int64 start;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedBlockTimer)
+    };
+
+    /** Records one block, given in high resolution ticks. Wait-free - audio thread only. */
+    void addBlock(juce::int64 ticks, int numSamples, double sampleRate) noexcept;
+
+    //==============================================================================
+    /** Moves everything waiting in the FIFO into the rolling history. Message thread only.
+        The first call allocates the FIFO and the history - blocks before then aren't recorded, only counted as overruns.
+    */
+    void update();
+
+    /** Throws away everything waiting in the FIFO and the rolling history, so the figures start afresh - an editor opening
+        after a long time closed shouldn't show blocks from back then. The overrun and dropped counts are kept. Message thread only.
+    */
+    void reset();
+
+    /** Returns min/mean/p99 over the rolling history. Call update() first. */
+    Stats getStats() const;
+
+    /** Writes the rolling history as CSV (oldest block first). Message thread only. */
+    bool writeCSV(const juce::File& file) const;
+
+private:
+    //==============================================================================
+    static constexpr int fifoSize = 1024;     // About 12 seconds of 512 sample blocks at 44.1kHz
+    static constexpr int historySize = 2048;
+
+    double nanosecondsPerTick;
+
+    juce::AbstractFifo fifo { fifoSize };
+    std::unique_ptr<BlockTiming[]> fifoStorage;          // Allocated by the first update(), then kept until the monitor goes
+    std::atomic<BlockTiming*> fifoData { nullptr };      // fifoStorage, handed to the audio thread once it's there
+    std::atomic<juce::uint32> overruns { 0 }, dropped { 0 };
+
+    // Consumer side - only touched on the message thread
+    std::vector<BlockTiming> history;
+    int historyStart = 0, historyCount = 0;
+    mutable std::vector<double> sortScratch;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PerformanceMonitor)
+};
@@ -0,0 +1,741 @@
+/*
+  ==============================================================================
+
+    PingPongKernel.h
+
+    The multichannel, multi-tap delay core. Every channel is processed in a
+    single pass over one interleaved DelayRing (one lane per channel), through
+    flat loops that vectorise across the lanes or down them.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "DelayRing.h"
+#include "DelayInterpolation.h"
+#include "DelayTaps.h"
+#include "FeedbackLoop.h"
+#include "WowFlutter.h"
+#include "SimdKernels.h"
+
+//==============================================================================
+/**
+    Fused N-channel, multi-tap ping-pong delay kernel.
+
+    Each channel's lane of the ring is read by every tap in the TapTable, at
+    the tap's fraction of the delay time. The taps are summed into the wet
+    outputs - each panned between its own channel and the next - and, scaled by
+    their share of the feedback, added back onto the input of the lane they
+    route to. The default (Classic) table is one tap with the odd channels at
+    0.79 of the delay, feeding its own lane - the original TENNISBOY sound.
+    With rotation on every tap's feedback moves one more lane on, so the
+    repeats travel round the bus: L -> R -> L for stereo, L -> R -> C -> ...
+    for surround.
+
+    The delay bank is one structure for all channels and taps rather than a
+    DelayLine per channel: one ring of [ch0 ch1 ... chN-1] frames, with the
+    taps' positions and fractions held per lane. A block is split into chunks
+    no longer than the shortest tap, so every tap in a chunk reads frames that
+    were written before the chunk started. Each chunk then takes two passes -
+    every tap of every lane is interpolated into a scratch span, one lane at a
+    time, then the write span and the outputs are mixed from that.
+
+    With the feedback loop switched on, the feedback of every tap is gathered
+    separately, run through a FeedbackLoop (low pass and soft clip) and only
+    then added onto the input, so each repeat is darker than the last.
+
+    With wow and flutter turned up, every lane's delay time moves a little each
+    sample (see WowFlutter). The taps are then read at per-sample fractional
+    positions: every (frame, channel) pair's read position is worked out first,
+    then the whole chunk is read in one go.
+
+    startCrossfade() switches the delay time without a glide: for a while
+    every tap is read twice, at the old and the new time, and the two heads
+    are crossfaded. Only one crossfade runs at a time.
+
+    setLatencyCompensation() makes up for latency added before the kernel (the
+    processor's oversampled input filter). The taps are output that much
+    sooner, so the first echo lands on the delay time, but the feedback is
+    still read at the full delay - the input is late, the repeats aren't, so
+    only the first pass needs moving. Each tap is then read twice, once for
+    the output and once for the feedback.
+
+    process() is templated on a DelayInterpolation policy. Pick the policy once
+    per block (see processWithQuality) - the loops themselves never branch on it.
+
+    SampleType is float or double. The audio, the ring and every tap are kept
+    at that precision; delay times and gains come in as floats.
+
+    The flat loops - the tap reads (all but Thiran's, which is recursive),
+    writing the input into the ring, mixing the taps out, the crossfade and the
+    wet gain - come from SimdKernels, built for every instruction set.
+    prepare() picks the best one the CPU has.
+*/
+template <typename SampleType>
+class PingPongKernel
+{
+public:
+    /** Most channels one kernel can run - enough for 7.1.4 with room to spare. */
+    static constexpr int maxChannels = 16;
+
+    /** Level (about -100dB) below which anything written to the ring counts as silence. */
+    static constexpr float silenceThreshold = 1.0e-5f;
+
+    PingPongKernel() = default;
+
+    //==============================================================================
+    /** Allocates the delay buffer for numChannels lanes. Not realtime safe. */
+    void prepare(int numChannelsToUse, int maximumDelayInSamples)
+    {
+        jassert(numChannelsToUse > 0 && numChannelsToUse <= maxChannels);
+
+        numChannels = juce::jlimit(1, maxChannels, numChannelsToUse);
+        maxDelay = juce::jmax(1, maximumDelayInSamples);
+
+        // Room for the oldest point the widest interpolator reads, on top of the longest delay and the longest chunk
+        ring.prepare(numChannels, maxDelay + DelayInterpolation::maxNumPoints, maxChunk + DelayInterpolation::maxNumPoints);
+        tapScratch.assign((size_t) (TapTable::maxTaps * maxChunk * numChannels), SampleType());
+        fadeScratch.assign(tapScratch.size(), SampleType());
+        feedbackScratch.assign(tapScratch.size(), SampleType());
+        fadeFeedbackScratch.assign(tapScratch.size(), SampleType());
+        loopScratch.assign((size_t) (maxChunk * numChannels), SampleType());
+        modulationScratch.assign((size_t) (maxChunk * numChannels), 0.0f);
+        tapOffsets.assign((size_t) (maxChunk * numChannels), 0);
+        tapFractions.assign((size_t) (maxChunk * numChannels), 0.0f);
+        setIsa(SimdKernels::getPreferredIsa());
+        reset();
+    }
+
+    /** Frees the delay buffer and the scratch spans until the next prepare() - process() mustn't be called in between. Not realtime safe. */
+    void release()
+    {
+        ring.release();
+        tapScratch = {};
+        fadeScratch = {};
+        feedbackScratch = {};
+        fadeFeedbackScratch = {};
+        loopScratch = {};
+        modulationScratch = {};
+        tapOffsets = {};
+        tapFractions = {};
+    }
+
+    /** Clears the delay buffer and the interpolator state. */
+    void reset() noexcept
+    {
+        ring.reset();
+
+        for (auto& lanes : interpolatorState)
+            std::fill(std::begin(lanes), std::end(lanes), SampleType());
+
+        for (auto& lanes : feedbackState)
+            std::fill(std::begin(lanes), std::end(lanes), SampleType());
+
+        fadeLength = 0;
+        feedbackLoop.reset();
+        modulation.reset();
+        framesSinceAudibleWrite = getLongestRead() + 1;
+    }
+
+    /** Switches the flat loops to another instruction set's build of SimdKernels - for tests and benchmarks, as prepare() picks
+        one already. One the CPU can't run gets the scalar loops. Realtime safe.
+    */
+    void setIsa(SimdKernels::Isa newIsa) noexcept
+    {
+        isa = SimdKernels::isSupported(newIsa) ? newIsa : SimdKernels::Isa::scalar;
+        kernels = &SimdKernels::getTable<SampleType>(isa);
+        feedbackLoop.setKernels(*kernels);
+    }
+
+    SimdKernels::Isa getIsa() const noexcept                        { return isa; }
+    const SimdKernels::Table<SampleType>& getKernels() const noexcept { return *kernels; }
+
+    int getNumChannels() const noexcept             { return numChannels; }
+    int getMaximumDelayInSamples() const noexcept   { return maxDelay; }
+
+    /** True once nothing above silenceThreshold is left anywhere a tap could read, i.e. every repeat has died away.
+        While this is true and the input is silent too, processing can be skipped without changing the output.
+    */
+    bool isSilent() const noexcept { return framesSinceAudibleWrite > getLongestRead(); }
+
+    //==============================================================================
+    /** Switches to a new tap table. Realtime safe - nothing is allocated, so it can be called at the start of a block. */
+    void setTapTable(const TapTable& newTable) noexcept
+    {
+        table = newTable.sanitised();
+
+        for (int t = 0; t < table.numTaps; ++t)
+        {
+            auto& tap = table.taps[(size_t) t];
+            auto angle = tap.pan * juce::MathConstants<float>::halfPi; // Equal power between own and next channel
+            routes[(size_t) t] = { tap.pan == 0.0f ? tap.gain : tap.gain * std::cos(angle),
+                                   tap.pan == 0.0f ? 0.0f : tap.gain * std::sin(angle) };
+        }
+    }
+
+    const TapTable& getTapTable() const noexcept { return table; }
+
+    //==============================================================================
+    /** Puts the feedback through getFeedbackLoop() (on) or straight back into the ring (off). Realtime safe - call it every block. */
+    void setFeedbackLoopEnabled(bool shouldBeEnabled) noexcept
+    {
+        if (shouldBeEnabled && ! loopEnabled)
+            feedbackLoop.reset(); // Don't start from whatever the filter held the last time it was on
+
+        loopEnabled = shouldBeEnabled;
+    }
+
+    /** The in-loop filter and soft clip. Prepare it with the sample rate and set its cutoff and Q from outside. */
+    FeedbackLoop<SampleType>& getFeedbackLoop() noexcept { return feedbackLoop; }
+
+    /** The wow and flutter LFOs. Prepare them with the sample rate and set their depths from outside - at zero depth they cost nothing. */
+    WowFlutter& getModulation() noexcept { return modulation; }
+
+    //==============================================================================
+    /** Reads the taps' output this many samples (fractions included) before their delay time, to make up for a wet input that
+        arrives late - the feedback still reads at the full delay, so every repeat after the first stays a delay time after the one
+        before. A tap shorter than that is output as soon as it can be, at no delay. Realtime safe.
+    */
+    void setLatencyCompensation(float samples) noexcept
+    {
+        samples = juce::jmax(0.0f, samples);
+
+        if (samples > 0.0f && ! isCompensating())
+            std::memcpy(feedbackState, interpolatorState, sizeof(feedbackState)); // Until now one head did both jobs
+
+        latencyCompensation = samples;
+    }
+
+    float getLatencyCompensation() const noexcept { return latencyCompensation; }
+
+    //==============================================================================
+    /** Starts a crossfade from a head at fromDelay (in samples) to whatever delay the following process() calls ask for.
+
+        Use it to jump the Delay Time instead of ramping it, which would glide the pitch of
+        everything in the ring. The fade is linear and lasts lengthInSamples.
+
+        Wait for isCrossfading() to go false before starting another, and keep the delay
+        passed to process() where it is until then - starting one part way through would
+        cut off whichever head was going out. The processor holds on to the latest delay
+        time that comes in meanwhile and fades to that next.
+    */
+    void startCrossfade(float fromDelay, int lengthInSamples) noexcept
+    {
+        jassert(! isCrossfading());
+
+        std::memcpy(fadeState, interpolatorState, sizeof(fadeState)); // The old head carries on from the current one
+        std::memcpy(fadeFeedbackState, feedbackState, sizeof(fadeFeedbackState));
+
+        fadeFromDelay = fromDelay;
+        fadeLength = juce::jmax(1, lengthInSamples);
+        fadePosition = 0;
+    }
+
+    bool isCrossfading() const noexcept { return fadePosition < fadeLength; }
+
+    //==============================================================================
+    /** Runs the delay over a block of planar channels in place.
+
+        delay is the Delay Time in samples (the taps read at their fractions of
+        it), feedback is the gain fed back into the ring and wetGain scales the
+        taps written to the output. With rotate set, the feedback moves one
+        more lane on.
+    */
+    template <typename Interpolation>
+    void process(SampleType* const* channels, int numSamples, float delay,
+                 float feedback, float wetGain, bool rotate) noexcept
+    {
+        if (modulation.isActive())
+        {
+            // Every sample reads from somewhere slightly different, so this is the per-sample path with constant values
+            processPerSample<Interpolation>(channels, numSamples, rotate, [delay] (int) { return delay; }, Gain { nullptr, feedback }, Gain { nullptr, wetGain });
+            return;
+        }
+
+        LaneTaps taps, fadeTaps, feedbackTaps, fadeFeedbackTaps;
+        auto chunkLength = makeTaps<Interpolation>(delay, latencyCompensation, taps);
+
+        if (isCrossfading())
+            chunkLength = juce::jmin(chunkLength, makeTaps<Interpolation>(fadeFromDelay, latencyCompensation, fadeTaps));
+
+        if (isCompensating()) // Always longer than the output taps, so they can't shorten the chunk
+        {
+            makeTaps<Interpolation>(delay, 0.0f, feedbackTaps);
+
+            if (isCrossfading())
+                makeTaps<Interpolation>(fadeFromDelay, 0.0f, fadeFeedbackTaps);
+        }
+
+        for (int start = 0; start < numSamples; start += chunkLength)
+        {
+            auto numFrames = juce::jmin(chunkLength, numSamples - start);
+
+            readTaps<Interpolation>(taps, numFrames, tapScratch, interpolatorState);
+
+            if (isCompensating())
+                readTaps<Interpolation>(feedbackTaps, numFrames, feedbackScratch, feedbackState);
+
+            if (isCrossfading())
+            {
+                readTaps<Interpolation>(fadeTaps, numFrames, fadeScratch, fadeState);
+
+                if (isCompensating())
+                    readTaps<Interpolation>(fadeFeedbackTaps, numFrames, fadeFeedbackScratch, fadeFeedbackState);
+
+                crossfadeTaps(numFrames);
+            }
+
+            writeAndOutput(channels, start, numFrames, rotate, Gain { nullptr, feedback }, Gain { nullptr, wetGain });
+        }
+    }
+
+    /** Runs the delay over a block of planar channels in place, with per-sample delay time, feedback and wet gain.
+
+        Used while parameters are ramping.
+    */
+    template <typename Interpolation>
+    void process(SampleType* const* channels, int numSamples, const float* delay,
+                 const float* feedback, const float* wetGain, bool rotate) noexcept
+    {
+        processPerSample<Interpolation>(channels, numSamples, rotate, [delay] (int i) { return delay[i]; }, Gain { feedback }, Gain { wetGain });
+    }
+
+    //==============================================================================
+    /** Picks the specialised kernel for a quality setting, then runs it. Any of the process() overloads' arguments can follow. */
+    template <typename... Args>
+    void processWithQuality(DelayInterpolation::Quality quality, Args... args) noexcept
+    {
+        switch (quality)
+        {
+            case DelayInterpolation::Quality::none:      process<DelayInterpolation::None>(args...); break;
+            case DelayInterpolation::Quality::lagrange3: process<DelayInterpolation::Lagrange3>(args...); break;
+            case DelayInterpolation::Quality::thiran:    process<DelayInterpolation::Thiran>(args...); break;
+            case DelayInterpolation::Quality::linear:
+            default:                                     process<DelayInterpolation::Linear>(args...); break;
+        }
+    }
+
+private:
+    //==============================================================================
+    /** Output gains for a tap, worked out from its gain and pan when the table is set. */
+    struct TapRoute
+    {
+        float ownGain = 1.0f, nextGain = 0.0f;
+    };
+
+    /** A gain that's either one value for a whole call or one per sample. */
+    struct Gain
+    {
+        const float* values = nullptr; // One per sample, or nullptr to use constant
+        float constant = 0.0f;
+
+        float operator() (int i) const noexcept         { return values != nullptr ? values[i] : constant; }
+        Gain from(int start) const noexcept             { return values != nullptr ? Gain { values + start, constant } : *this; }
+    };
+
+    float getTapDelay(float delay, int tap, int channel) const noexcept
+    {
+        auto tapDelay = delay * table.taps[(size_t) tap].ratio;
+        return channel % 2 == 0 ? tapDelay : tapDelay * table.oddChannelRatio;
+    }
+
+    bool isCompensating() const noexcept { return latencyCompensation > 0.0f; }
+
+    /** Age of the oldest frame any tap can read - the longest delay, plus the points the widest interpolator (Lagrange3) reads behind it. */
+    int getLongestRead() const noexcept { return maxDelay + DelayInterpolation::maxNumPoints - 1; }
+
+    SampleType* getTapScratch(std::vector<SampleType>& scratch, int tap) noexcept { return scratch.data() + (size_t) (tap * maxChunk * numChannels); }
+
+    /** Every tap of every lane at one delay time, split up for an interpolator. */
+    using LaneTaps = std::array<std::array<DelayInterpolation::Tap, maxChannels>, TapTable::maxTaps>;
+
+    /** Fills in the taps for a constant delay time, each read advance samples early. Returns the longest chunk they can all be read for. */
+    template <typename Interpolation>
+    int makeTaps(float delay, float advance, LaneTaps& taps) const noexcept
+    {
+        auto shortest = maxDelay;
+
+        for (int t = 0; t < table.numTaps; ++t)
+        {
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                auto& tap = taps[(size_t) t][(size_t) channel];
+                tap = Interpolation::makeTap(juce::jlimit(0.0f, (float) maxDelay, getTapDelay(delay, t, channel) - advance));
+                shortest = juce::jmin(shortest, tap.whole);
+            }
+        }
+
+        // Below one sample of delay the tap reads the frame about to be overwritten, so go a frame at a time
+        return juce::jlimit(1, (int) maxChunk, shortest);
+    }
+
+    /** First pass over a chunk: interpolates every tap of every lane into scratch. */
+    template <typename Interpolation>
+    void readTaps(const LaneTaps& taps, int numFrames, std::vector<SampleType>& scratch,
+                  SampleType (&state)[TapTable::maxTaps][maxChannels]) noexcept
+    {
+        constexpr int numPoints = Interpolation::numPoints;
+
+        for (int t = 0; t < table.numTaps; ++t)
+        {
+            auto& tapsForLanes = taps[(size_t) t];
+            auto* tapOut = getTapScratch(scratch, t);
+
+            // Spans start at the oldest point each lane reads - point k for frame i is (i + numPoints - 1 - k) frames along
+            std::array<const SampleType*, maxChannels> oldest;
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                oldest[(size_t) channel] = ring.getReadPointer(tapsForLanes[(size_t) channel].whole + numPoints - 1) + channel;
+
+            if constexpr (! Interpolation::isRecursive)
+            {
+                // Each lane reads at its own constant fraction, so it's one flat loop down the lane
+                for (int channel = 0; channel < numChannels; ++channel)
+                    (kernels->*getLaneRead<Interpolation>())(tapOut + channel, oldest[(size_t) channel] + (numPoints - 1) * numChannels,
+                                                              numChannels, (SampleType) tapsForLanes[(size_t) channel].frac, numFrames);
+            }
+            else
+            {
+                int frame = 0, lane = 0;
+
+                // Recursive interpolators carry each value into the next, so they go through one value at a time
+                for (int j = 0; j < numFrames * numChannels; ++j) // j runs over (frame, lane) pairs in ring order
+                {
+                    auto& tap = tapsForLanes[(size_t) lane];
+                    auto* lanePoints = oldest[(size_t) lane] + (frame + numPoints - 1) * numChannels;
+                    SampleType points[numPoints];
+
+                    for (int k = 0; k < numPoints; ++k)
+                        points[k] = lanePoints[-k * numChannels];
+
+                    tapOut[j] = Interpolation::interpolate(points, (SampleType) tap.frac, (SampleType) tap.alpha, state[t][lane]);
+
+                    if (++lane == numChannels)
+                    {
+                        lane = 0;
+                        ++frame;
+                    }
+                }
+            }
+        }
+    }
+
+    /** The per-sample path behind both process() overloads - used while parameters ramp or wow and flutter are on.
+
+        The taps are still read from published frames only, so each chunk is kept no longer than
+        the shortest tap it sees. The wow and flutter offsets only ever make a tap longer, so the
+        unmodulated delay is enough to find that.
+    */
+    template <typename Interpolation, typename DelayAt>
+    void processPerSample(SampleType* const* channels, int numSamples, bool rotate,
+                          DelayAt delayAt, Gain feedback, Gain wetGain) noexcept
+    {
+        auto tapAt = [this] (float tapDelay) { return Interpolation::makeTap(juce::jlimit(0.0f, (float) maxDelay, tapDelay)); };
+
+        // Delay ramps are linear, so checking the first and last sample of a chunk is enough. Only the
+        // first two lanes need looking at - every other lane reads at the same delay as one of them. The
+        // output taps are the shortest, so the feedback ones needn't be looked at
+        auto shortestAt = [&] (int i)
+        {
+            auto shortest = maxDelay;
+
+            for (int t = 0; t < table.numTaps; ++t)
+            {
+                for (int channel = 0; channel < juce::jmin(2, numChannels); ++channel)
+                {
+                    shortest = juce::jmin(shortest, tapAt(getTapDelay(delayAt(i), t, channel) - latencyCompensation).whole);
+
+                    if (isCrossfading())
+                        shortest = juce::jmin(shortest, tapAt(getTapDelay(fadeFromDelay, t, channel) - latencyCompensation).whole);
+                }
+            }
+
+            return shortest;
+        };
+
+        for (int start = 0; start < numSamples;)
+        {
+            auto numFrames = juce::jlimit(1, juce::jmin((int) maxChunk, numSamples - start), shortestAt(start));
+
+            while (numFrames > 1 && shortestAt(start + numFrames - 1) < numFrames)
+                numFrames = juce::jmax(1, shortestAt(start + numFrames - 1));
+
+            const float* offsets = nullptr;
+
+            if (modulation.isActive())
+            {
+                modulation.fill(modulationScratch.data(), numFrames);
+                offsets = modulationScratch.data();
+            }
+
+            auto delayFrom = [&delayAt, start] (int i) { return delayAt(start + i); };
+            auto fadeDelay = [this] (int) { return fadeFromDelay; };
+
+            readTapsAt<Interpolation>(delayFrom, latencyCompensation, offsets, numFrames, tapScratch, interpolatorState);
+
+            if (isCompensating())
+                readTapsAt<Interpolation>(delayFrom, 0.0f, offsets, numFrames, feedbackScratch, feedbackState);
+
+            if (isCrossfading())
+            {
+                // Both heads are on the same wobbling tape, so the old one gets the same offsets
+                readTapsAt<Interpolation>(fadeDelay, latencyCompensation, offsets, numFrames, fadeScratch, fadeState);
+
+                if (isCompensating())
+                    readTapsAt<Interpolation>(fadeDelay, 0.0f, offsets, numFrames, fadeFeedbackScratch, fadeFeedbackState);
+
+                crossfadeTaps(numFrames);
+            }
+
+            writeAndOutput(channels, start, numFrames, rotate, feedback.from(start), wetGain.from(start));
+
+            start += numFrames;
+        }
+    }
+
+    /** First pass over a chunk for the per-sample path: like readTaps, but every (frame, lane) pair reads at its own delay -
+        delayAt(frame), plus that pair's offset when there are any - less advance.
+    */
+    template <typename Interpolation, typename DelayAt>
+    void readTapsAt(DelayAt delayAt, float advance, const float* offsets, int numFrames, std::vector<SampleType>& scratch,
+                    SampleType (&state)[TapTable::maxTaps][maxChannels]) noexcept
+    {
+        constexpr int numPoints = Interpolation::numPoints;
+        auto numValues = numFrames * numChannels;
+        auto tapDelayAt = [&] (int t, int j, int frame, int lane)
+        {
+            return getTapDelay(delayAt(frame) + (offsets != nullptr ? offsets[j] : 0.0f), t, lane) - advance;
+        };
+
+        for (int t = 0; t < table.numTaps; ++t)
+        {
+            auto* tapOut = getTapScratch(scratch, t);
+            int frame = 0, lane = 0;
+
+            if constexpr (! Interpolation::isRecursive)
+            {
+                // Every value's newest point, as an offset from the newest frame in the ring, and its fraction - then the
+                // loads and the arithmetic are one flat loop over the chunk
+                auto* newestFrame = ring.getReadPointer(0);
+
+                for (int j = 0; j < numValues; ++j) // j runs over (frame, lane) pairs in ring order
+                {
+                    auto tap = Interpolation::makeTap(juce::jlimit(0.0f, (float) maxDelay, tapDelayAt(t, j, frame, lane)));
+                    tapOffsets[(size_t) j] = (int) (getFramePoints<numPoints>(tap, frame, lane) - newestFrame);
+                    tapFractions[(size_t) j] = tap.frac;
+
+                    if (++lane == numChannels)
+                    {
+                        lane = 0;
+                        ++frame;
+                    }
+                }
+
+                (kernels->*getReadAt<Interpolation>())(tapOut, newestFrame, tapOffsets.data(), tapFractions.data(), numChannels, numValues);
+            }
+            else
+            {
+                for (int j = 0; j < numValues; ++j)
+                {
+                    tapOut[j] = readFrame<Interpolation>(tapDelayAt(t, j, frame, lane), frame, lane, state[t][lane]);
+
+                    if (++lane == numChannels)
+                    {
+                        lane = 0;
+                        ++frame;
+                    }
+                }
+            }
+        }
+    }
+
+    /** The SimdKernels tap read for a non-recursive interpolator, at a constant delay per lane. */
+    template <typename Interpolation>
+    static constexpr auto getLaneRead() noexcept
+    {
+        if constexpr (std::is_same_v<Interpolation, DelayInterpolation::None>)
+            return &SimdKernels::Table<SampleType>::readLaneNearest;
+        else if constexpr (std::is_same_v<Interpolation, DelayInterpolation::Linear>)
+            return &SimdKernels::Table<SampleType>::readLaneLinear;
+        else
+        {
+            static_assert(std::is_same_v<Interpolation, DelayInterpolation::Lagrange3>, "Recursive interpolators are read in PingPongKernel");
+            return &SimdKernels::Table<SampleType>::readLaneLagrange3;
+        }
+    }
+
+    /** The same, with a delay for every value. */
+    template <typename Interpolation>
+    static constexpr auto getReadAt() noexcept
+    {
+        if constexpr (std::is_same_v<Interpolation, DelayInterpolation::None>)
+            return &SimdKernels::Table<SampleType>::readNearestAt;
+        else if constexpr (std::is_same_v<Interpolation, DelayInterpolation::Linear>)
+            return &SimdKernels::Table<SampleType>::readLinearAt;
+        else
+        {
+            static_assert(std::is_same_v<Interpolation, DelayInterpolation::Lagrange3>, "Recursive interpolators are read in PingPongKernel");
+            return &SimdKernels::Table<SampleType>::readLagrange3At;
+        }
+    }
+
+    /** Where one lane of one frame of the chunk starts reading a tap - its newest point, with the older ones a frame apart behind it. */
+    template <int numPoints>
+    const SampleType* getFramePoints(const DelayInterpolation::Tap& tap, int frame, int channel) const noexcept
+    {
+        // Each frame's taps sit one frame further on from where the chunk's read position is
+        return ring.getReadPointer(tap.whole + numPoints - 1) + (frame + numPoints - 1) * numChannels + channel;
+    }
+
+    /** Reads one lane of one frame of the chunk at any delay - the per-sample path used while the delay is ramping. */
+    template <typename Interpolation>
+    SampleType readFrame(float tapDelay, int frame, int channel, SampleType& state) const noexcept
+    {
+        constexpr int numPoints = Interpolation::numPoints;
+        auto tap = Interpolation::makeTap(juce::jlimit(0.0f, (float) maxDelay, tapDelay));
+        auto* lanePoints = getFramePoints<numPoints>(tap, frame, channel);
+        SampleType points[numPoints];
+
+        for (int k = 0; k < numPoints; ++k)
+            points[k] = lanePoints[-k * numChannels];
+
+        return Interpolation::interpolate(points, (SampleType) tap.frac, (SampleType) tap.alpha, state);
+    }
+
+    /** Mixes the outgoing head (fadeScratch) into the incoming one (tapScratch) and moves the crossfade on - and the same for their
+        feedback reads, while compensating.
+    */
+    void crossfadeTaps(int numFrames) noexcept
+    {
+        for (int t = 0; t < table.numTaps; ++t)
+        {
+            kernels->crossfade(getTapScratch(tapScratch, t), getTapScratch(fadeScratch, t), numFrames, numChannels, fadePosition, fadeLength);
+
+            if (isCompensating())
+                kernels->crossfade(getTapScratch(feedbackScratch, t), getTapScratch(fadeFeedbackScratch, t), numFrames, numChannels, fadePosition, fadeLength);
+        }
+
+        fadePosition = juce::jmin(fadeLength, fadePosition + numFrames);
+    }
+
+    /** Second pass over a chunk: mixes the taps in tapScratch into the outputs and feeds them back into the ring - or the ones in
+        feedbackScratch, while compensating.
+    */
+    void writeAndOutput(SampleType* const* channels, int start, int numFrames, bool rotate, Gain feedback, Gain wetGain) noexcept
+    {
+        auto* dest = ring.getWritePointer();
+        auto* feedbackDest = loopEnabled ? loopScratch.data() : dest; // With the loop on, the feedback is gathered on its own first
+
+        if (loopEnabled)
+            std::fill(loopScratch.begin(), loopScratch.begin() + numFrames * numChannels, SampleType());
+
+        // The input goes into the ring as it is, and the outputs are rebuilt from the taps
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto* io = channels[channel] + start;
+            kernels->copyToLane(dest + channel, numChannels, io, numFrames);
+            std::fill(io, io + numFrames, SampleType());
+        }
+
+        for (int t = 0; t < table.numTaps; ++t)
+        {
+            auto& tap = table.taps[(size_t) t];
+            auto* tapOut = getTapScratch(tapScratch, t);
+            auto* tapFeedback = isCompensating() ? getTapScratch(feedbackScratch, t) : tapOut;
+            auto feedbackOffset = (tap.feedbackTo + (rotate ? 1 : 0)) % numChannels;
+            auto ownGain = (SampleType) (numChannels > 1 ? routes[(size_t) t].ownGain : tap.gain); // Nowhere to pan to in mono
+            auto nextGain = (SampleType) (numChannels > 1 ? routes[(size_t) t].nextGain : 0.0f);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                auto* own = channels[channel] + start;
+                auto* next = channels[(channel + 1) % numChannels] + start;
+                auto feedbackLane = (channel + feedbackOffset) % numChannels; // Rotating, a lane feeds the one after it
+
+                kernels->addFromLane(own, tapOut + channel, numChannels, ownGain, numFrames);
+
+                if (nextGain != SampleType())
+                    kernels->addFromLane(next, tapOut + channel, numChannels, nextGain, numFrames);
+
+                if (tap.feedback == 0.0f)
+                    continue;
+
+                if (feedback.values == nullptr)
+                {
+                    auto gain = (SampleType) (feedback.constant * tap.feedback);
+
+                    for (int i = 0; i < numFrames; ++i)
+                        feedbackDest[i * numChannels + feedbackLane] += tapFeedback[i * numChannels + channel] * gain;
+                }
+                else
+                {
+                    for (int i = 0; i < numFrames; ++i)
+                        feedbackDest[i * numChannels + feedbackLane] += tapFeedback[i * numChannels + channel] * (SampleType) (feedback.values[i] * tap.feedback);
+                }
+            }
+        }
+
+        if (loopEnabled)
+        {
+            feedbackLoop.process(feedbackDest, numFrames);
+            kernels->add(dest, feedbackDest, numFrames * numChannels);
+        }
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            if (wetGain.values != nullptr)
+                kernels->multiplyByGains(channels[channel] + start, wetGain.values, numFrames);
+            else
+                kernels->multiply(channels[channel] + start, (SampleType) wetGain.constant, numFrames);
+        }
+
+        // The write span is contiguous, so this is one vectorised scan per chunk
+        auto written = juce::FloatVectorOperations::findMinAndMax(dest, numFrames * numChannels);
+
+        if (juce::jmax(-written.getStart(), written.getEnd()) > (SampleType) silenceThreshold)
+            framesSinceAudibleWrite = 0;
+        else if (framesSinceAudibleWrite <= getLongestRead())
+            framesSinceAudibleWrite += numFrames;
+
+        ring.advance(numFrames);
+    }
+
+    //==============================================================================
+    static constexpr int maxChunk = 512; // Longest span read or written in one go - sets the size of the ring's mirrored tail
+
+    //==============================================================================
+    DelayRing<SampleType> ring; // Interleaved frames, one lane per channel
+    int numChannels = 2, maxDelay = 0;
+    int framesSinceAudibleWrite = 0; // Age of the newest frame in the ring above silenceThreshold
+
+    TapTable table;
+    std::array<TapRoute, TapTable::maxTaps> routes;
+
+    std::vector<SampleType> tapScratch; // One chunk of interpolated taps per tap, interleaved like the ring
+    SampleType interpolatorState[TapTable::maxTaps][maxChannels] = {}; // Only the recursive (Thiran) interpolator uses this
+
+    std::vector<SampleType> fadeScratch; // The outgoing head's taps while crossfading, laid out like tapScratch
+    SampleType fadeState[TapTable::maxTaps][maxChannels] = {};
+    float fadeFromDelay = 0.0f;
+    int fadeLength = 0, fadePosition = 0; // Not crossfading once fadePosition reaches fadeLength
+
+    float latencyCompensation = 0.0f; // Samples the output taps read early - the feedback ones below only run while it's above zero
+    std::vector<SampleType> feedbackScratch, fadeFeedbackScratch; // Both heads' taps at the full delay, laid out like tapScratch
+    SampleType feedbackState[TapTable::maxTaps][maxChannels] = {}, fadeFeedbackState[TapTable::maxTaps][maxChannels] = {};
+
+    FeedbackLoop<SampleType> feedbackLoop;
+    std::vector<SampleType> loopScratch; // One chunk of feedback, interleaved like the ring, while the loop is on
+    bool loopEnabled = false;
+
+    WowFlutter modulation;
+    std::vector<float> modulationScratch; // One chunk of delay offsets, interleaved like the ring, while wow or flutter is on
+    std::vector<int> tapOffsets;          // Where each value of a chunk reads, and at what fraction, for readTapsAt
+    std::vector<float> tapFractions;
+
+    SimdKernels::Isa isa = SimdKernels::Isa::scalar;
+    const SimdKernels::Table<SampleType>* kernels = &SimdKernels::getTable<SampleType>(SimdKernels::Isa::scalar); // The flat loops, for isa
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PingPongKernel)
+};
@@ -1,124 +1,352 @@
-/*
-  ==============================================================================
-
-    This file contains the basic framework code for a JUCE plugin editor.
-
-  ==============================================================================
-*/
-
-#include "PluginProcessor.h"
-#include "PluginEditor.h"
-
-//==============================================================================
-TableTennisAudioProcessorEditor::TableTennisAudioProcessorEditor(TableTennisAudioProcessor& p, juce::AudioProcessorValueTreeState& vts)
-    : AudioProcessorEditor(&p), audioProcessor(p), treeState(vts)
-{
-    // Define plugin Window Size
-    setSize(400, 400);
-
-
-    // Create Delay time control
-
-    delayTimeValue = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(treeState, "delayTime", delayTimeSlider);           //Create a slider Attachment
-    delayTimeSlider.setSliderStyle(juce::Slider::RotaryVerticalDrag);                                                                                 //Define Slider as Vertical Drag Rotary Knob
-    delayTimeSlider.setRange(1.0f, 3000.0f, 1.0f);                                                                     //Set parameter value range and interval
-    delayTimeSlider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::TextBoxBelow, false, 75, 25);       //Text Box placement - Set to be able to type value in, i.e. "Read Only = False"
-    addAndMakeVisible(&delayTimeSlider);                                                                                                            //Add to display
-
-    addAndMakeVisible(delayTimeLabel);                                                                                                          //Add Parameter label to display
-    delayTimeLabel.setText("Delay time (mS)", juce::dontSendNotification);                                                                 //Set Text
-    delayTimeLabel.attachToComponent(&delayTimeSlider, false);                                                                              //Attach to slider, centre above
-    delayTimeLabel.setJustificationType(juce::Justification::centred);                                                                          //Text Justification centred
-
-
-
-
-    // Create Feedback Control
-    feedbackValue = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(treeState, "feedback", feedbackSlider);
-    feedbackSlider.setSliderStyle(juce::Slider::RotaryVerticalDrag);
-    feedbackSlider.setRange(0.0f, 0.99f, 0.01f);
-    feedbackSlider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::TextBoxBelow, false, 75, 25);
-    addAndMakeVisible(&feedbackSlider);
-
-    addAndMakeVisible(feedbackLabel);
-    feedbackLabel.setText("Feedback", juce::dontSendNotification);
-    feedbackLabel.attachToComponent(&feedbackSlider, false);
-    feedbackLabel.setJustificationType(juce::Justification::centred);
-
-    // Create Wet/Dry Control
-    wetDryValue = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(treeState, "wetDry", wetDrySlider);
-    wetDrySlider.setSliderStyle(juce::Slider::RotaryVerticalDrag);
-    wetDrySlider.setRange(0.0f, 1.0f, 0.01f);
-    wetDrySlider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::TextBoxBelow, false, 75, 25);
-    addAndMakeVisible(&wetDrySlider);
-
-    addAndMakeVisible(wetDryLabel);
-    wetDryLabel.setText("Mix", juce::dontSendNotification);
-    wetDryLabel.attachToComponent(&wetDrySlider, false);
-    wetDryLabel.setJustificationType(juce::Justification::centred);
-
-
-    //Create LPF Control
-    lpfValue = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(treeState, "lpf", lpfSlider);
-    lpfSlider.setSliderStyle(juce::Slider::RotaryVerticalDrag);
-    lpfSlider.setRange(1.0f, 20000.0f, 1.0f);
-    lpfSlider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::TextBoxBelow, false, 75, 25);
-    addAndMakeVisible(&lpfSlider);
-
-    addAndMakeVisible(lpfLabel);
-    lpfLabel.setText("Cutoff (Hz)", juce::dontSendNotification);
-    lpfLabel.attachToComponent(&lpfSlider, false);
-    lpfLabel.setJustificationType(juce::Justification::centred);
-
-    //Create Resonance Control
-    qValue = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(treeState, "Q", qSlider);
-    qSlider.setSliderStyle(juce::Slider::RotaryVerticalDrag);
-    qSlider.setRange(0.1f, 15.0f, 0.1f);
-    qSlider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::TextBoxBelow, false, 75, 25);
-    addAndMakeVisible(&qSlider);
-
-    addAndMakeVisible(qLabel);
-    qLabel.setText("Q", juce::dontSendNotification);
-    qLabel.attachToComponent(&qSlider, false);
-    qLabel.setJustificationType(juce::Justification::centred);
-
-
-
-   
-}
-
-TableTennisAudioProcessorEditor::~TableTennisAudioProcessorEditor()
-{
-
-}
-
-//==============================================================================
-void TableTennisAudioProcessorEditor::paint(juce::Graphics& g)
-{
-    {
-        //Set up Graphics characteristics
-
-
-        g.fillAll(juce::Colours::grey); // Fill colour - Grey
-        g.setColour(juce::Colours::white); // Text colour - White
-        g.setFont(20); // Font Size
-        g.drawFittedText("TENNISBOY jr", 80, 30, 250, 15, juce::Justification::centred, 1, 1.0f); //Draw title Text
-        g.setFont(18); // Font Size
-    	g.drawFittedText("Effect LPF", 120, 230, 150, 10, juce::Justification::centred, 1, 1.0f); // Draw LPF title text
-        g.setFont(15); // Font Size
-    	g.drawFittedText("loudtoys", 5, 10, 80, 5, juce::Justification::centred, 1, 1.0f);
-        g.setFont(10); // Font Size
-        g.drawFittedText("Scamalogue Echo Processor", 250, 10, 150, 5, juce::Justification::centred, 1, 1.0f);
-    }
-}
-
-void TableTennisAudioProcessorEditor::resized()
-{
-    //Positioning of Sub-components, (x, y, width, height)
-
-    delayTimeSlider.setBounds(50, 85, 120, 120);
-    feedbackSlider.setBounds(150, 85, 120, 120);
-    wetDrySlider.setBounds(250, 85, 120, 120);
-    lpfSlider.setBounds(100, 280, 80, 80);
-    qSlider.setBounds(200, 280, 80, 80);
-}
+/*
+  ==============================================================================
+
+    This file contains the basic framework code for a JUCE plugin editor.
+
+  ==============================================================================
+*/
+
+#include "PluginProcessor.h"
+#include "PluginEditor.h"
+
+//==============================================================================
+TableTennisAudioProcessorEditor::TableTennisAudioProcessorEditor(TableTennisAudioProcessor& p, juce::AudioProcessorValueTreeState& vts)
+    : AudioProcessorEditor(&p), audioProcessor(p), treeState(vts), tapVisualiser(p.getTapMeter())
+{
+    setOpaque(true); // The cached background covers the whole window, so nothing behind the editor ever needs drawing
+    // Define plugin Window Size
+    setSize(400, 575);
+
+
+    // Create Delay time control
+
+    delayTimeValue = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(treeState, "delayTime", delayTimeSlider);           //Create a slider Attachment
+    delayTimeSlider.setSliderStyle(juce::Slider::RotaryVerticalDrag);                                                                                 //Define Slider as Vertical Drag Rotary Knob
+    delayTimeSlider.setRange(1.0f, 3000.0f, 1.0f);                                                                     //Set parameter value range and interval
+    delayTimeSlider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::TextBoxBelow, false, 75, 25);       //Text Box placement - Set to be able to type value in, i.e. "Read Only = False"
+    addAndMakeVisible(&delayTimeSlider);                                                                                                            //Add to display
+
+    addAndMakeVisible(delayTimeLabel);                                                                                                          //Add Parameter label to display
+    delayTimeLabel.setText("Delay time (mS)", juce::dontSendNotification);                                                                 //Set Text
+    delayTimeLabel.attachToComponent(&delayTimeSlider, false);                                                                              //Attach to slider, centre above
+    delayTimeLabel.setJustificationType(juce::Justification::centred);                                                                          //Text Justification centred
+
+
+
+
+    // Create Feedback Control
+    feedbackValue = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(treeState, "feedback", feedbackSlider);
+    feedbackSlider.setSliderStyle(juce::Slider::RotaryVerticalDrag);
+    feedbackSlider.setRange(0.0f, 0.99f, 0.01f);
+    feedbackSlider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::TextBoxBelow, false, 75, 25);
+    addAndMakeVisible(&feedbackSlider);
+
+    addAndMakeVisible(feedbackLabel);
+    feedbackLabel.setText("Feedback", juce::dontSendNotification);
+    feedbackLabel.attachToComponent(&feedbackSlider, false);
+    feedbackLabel.setJustificationType(juce::Justification::centred);
+
+    // Create Wet/Dry Control
+    wetDryValue = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(treeState, "wetDry", wetDrySlider);
+    wetDrySlider.setSliderStyle(juce::Slider::RotaryVerticalDrag);
+    wetDrySlider.setRange(0.0f, 1.0f, 0.01f);
+    wetDrySlider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::TextBoxBelow, false, 75, 25);
+    addAndMakeVisible(&wetDrySlider);
+
+    addAndMakeVisible(wetDryLabel);
+    wetDryLabel.setText("Mix", juce::dontSendNotification);
+    wetDryLabel.attachToComponent(&wetDrySlider, false);
+    wetDryLabel.setJustificationType(juce::Justification::centred);
+
+
+    //Create LPF Control
+    lpfValue = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(treeState, "lpf", lpfSlider);
+    lpfSlider.setSliderStyle(juce::Slider::RotaryVerticalDrag);
+    lpfSlider.setRange(1.0f, 20000.0f, 1.0f);
+    lpfSlider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::TextBoxBelow, false, 75, 25);
+    addAndMakeVisible(&lpfSlider);
+
+    addAndMakeVisible(lpfLabel);
+    lpfLabel.setText("Cutoff (Hz)", juce::dontSendNotification);
+    lpfLabel.attachToComponent(&lpfSlider, false);
+    lpfLabel.setJustificationType(juce::Justification::centred);
+
+    //Create Resonance Control
+    qValue = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(treeState, "Q", qSlider);
+    qSlider.setSliderStyle(juce::Slider::RotaryVerticalDrag);
+    qSlider.setRange(0.1f, 15.0f, 0.1f);
+    qSlider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::TextBoxBelow, false, 75, 25);
+    addAndMakeVisible(&qSlider);
+
+    addAndMakeVisible(qLabel);
+    qLabel.setText("Q", juce::dontSendNotification);
+    qLabel.attachToComponent(&qSlider, false);
+    qLabel.setJustificationType(juce::Justification::centred);
+
+    //Create Interpolation Control - items have to be added before the attachment so it can select the current one
+    qualityBox.addItemList(DelayInterpolation::getQualityNames(), 1);
+    qualityValue = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(treeState, "quality", qualityBox);
+    addAndMakeVisible(qualityBox);
+
+    addAndMakeVisible(qualityLabel);
+    qualityLabel.setText("Interpolation", juce::dontSendNotification);
+    qualityLabel.attachToComponent(&qualityBox, false);
+    qualityLabel.setJustificationType(juce::Justification::centred);
+
+    //Create Tap Pattern Control
+    tapsBox.addItemList(TapPatterns::getNames(), 1);
+    tapsValue = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(treeState, "taps", tapsBox);
+    addAndMakeVisible(tapsBox);
+
+    addAndMakeVisible(tapsLabel);
+    tapsLabel.setText("Taps", juce::dontSendNotification);
+    tapsLabel.attachToComponent(&tapsBox, false);
+    tapsLabel.setJustificationType(juce::Justification::centred);
+
+    //Create Ping-pong Control
+    pingPongValue = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(treeState, "pingPong", pingPongButton);
+    pingPongButton.setColour(juce::ToggleButton::textColourId, juce::Colours::white);
+    addAndMakeVisible(pingPongButton);
+
+    //Create LPF placement Control
+    loopFilterValue = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(treeState, "loopFilter", loopFilterButton);
+    loopFilterButton.setColour(juce::ToggleButton::textColourId, juce::Colours::white);
+    loopFilterButton.setTooltip("Moves the LPF into the feedback loop with a soft clip, so every repeat is darker than the last");
+    addAndMakeVisible(loopFilterButton);
+
+    //Create Wow and Flutter Controls
+    for (auto* slider : { &wowSlider, &flutterSlider })
+    {
+        slider->setSliderStyle(juce::Slider::RotaryVerticalDrag);
+        slider->setTextBoxStyle(juce::Slider::TextEntryBoxPosition::TextBoxBelow, false, 60, 20);
+        addAndMakeVisible(slider);
+    }
+
+    wowValue = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(treeState, "wow", wowSlider);
+    flutterValue = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(treeState, "flutter", flutterSlider);
+
+    addAndMakeVisible(wowLabel);
+    wowLabel.setText("Wow", juce::dontSendNotification);
+    wowLabel.attachToComponent(&wowSlider, false);
+    wowLabel.setJustificationType(juce::Justification::centred);
+
+    addAndMakeVisible(flutterLabel);
+    flutterLabel.setText("Flutter", juce::dontSendNotification);
+    flutterLabel.attachToComponent(&flutterSlider, false);
+    flutterLabel.setJustificationType(juce::Justification::centred);
+
+    //Create LPF oversampling Control
+    oversamplingBox.addItemList({ "Off", "2x", "4x" }, 1);
+    oversamplingValue = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(treeState, "oversampling", oversamplingBox);
+    oversamplingBox.setTooltip("Runs the LPF at a higher sample rate - cleaner high cutoffs and resonance, for more CPU");
+    addAndMakeVisible(oversamplingBox);
+
+    addAndMakeVisible(oversamplingLabel);
+    oversamplingLabel.setText("Oversample", juce::dontSendNotification);
+    oversamplingLabel.attachToComponent(&oversamplingBox, false);
+    oversamplingLabel.setJustificationType(juce::Justification::centred);
+
+    //Create Long delay Controls
+    longDelayValue = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(treeState, "longDelay", longDelayButton);
+    longDelayButton.setColour(juce::ToggleButton::textColourId, juce::Colours::white);
+    longDelayButton.setTooltip("Swaps the multi-tap delay for a single echo of up to a minute - memory is only used for the time you pick");
+    addAndMakeVisible(longDelayButton);
+
+    longTimeSlider.setSliderStyle(juce::Slider::LinearHorizontal);
+    longTimeSlider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::TextBoxRight, false, 55, 20);
+    longTimeSlider.setTextValueSuffix(" s");
+    longTimeValue = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(treeState, "longTime", longTimeSlider);
+    addAndMakeVisible(longTimeSlider);
+
+    freezeValue = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(treeState, "freeze", freezeButton);
+    freezeButton.setColour(juce::ToggleButton::textColourId, juce::Colours::white);
+    freezeButton.setTooltip("Loops whatever the long delay holds, ignoring the input and the feedback");
+    addAndMakeVisible(freezeButton);
+
+    //Create Tempo sync Controls
+    syncValue = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(treeState, "sync", syncButton);
+    syncButton.setColour(juce::ToggleButton::textColourId, juce::Colours::white);
+    syncButton.setTooltip("Takes the delay time from the host's tempo instead of the Delay time knob");
+    addAndMakeVisible(syncButton);
+
+    divisionBox.addItemList(TempoSync::getDivisionNames(), 1);
+    divisionValue = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(treeState, "division", divisionBox);
+    addAndMakeVisible(divisionBox);
+
+    transitionBox.addItemList(TempoSync::getTransitionNames(), 1);
+    transitionValue = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(treeState, "transition", transitionBox);
+    transitionBox.setTooltip("Glide sweeps the repeats to a new delay time or tempo, bending their pitch. Crossfade fades over to it in 20mS, and reads the delay without interpolation");
+    addAndMakeVisible(transitionBox);
+
+    addAndMakeVisible(transitionLabel);
+    transitionLabel.setText("Time change", juce::dontSendNotification);
+    transitionLabel.attachToComponent(&transitionBox, false);
+    transitionLabel.setJustificationType(juce::Justification::centred);
+    updateSyncControls();
+
+    //Create Automation resolution Control - item IDs are 1 + the index into getAutomationGranularities()
+    auto granularities = TableTennisAudioProcessor::getAutomationGranularities();
+
+    for (int i = 0; i < granularities.size(); ++i)
+        automationBox.addItem(granularities[i] > 0 ? juce::String(granularities[i]) + " smp" : juce::String("Per block"), i + 1);
+
+    automationBox.setTooltip("How often automated parameters are updated within each audio block");
+    automationBox.onChange = [this, granularities]
+    {
+        audioProcessor.setAutomationGranularity(granularities[juce::jmax(0, automationBox.getSelectedId() - 1)]);
+    };
+    updateAutomationBox();
+    addAndMakeVisible(automationBox);
+
+    addAndMakeVisible(automationLabel);
+    automationLabel.setText("Automation", juce::dontSendNotification);
+    automationLabel.attachToComponent(&automationBox, false);
+    automationLabel.setJustificationType(juce::Justification::centred);
+
+    //Create CPU meter
+    audioProcessor.getPerformanceMonitor().reset();                                                              //Start from fresh timings, not whatever queued up while the editor was closed
+    cpuLabel.setFont(12.0f);
+    cpuLabel.setColour(juce::Label::textColourId, juce::Colours::white);
+    cpuLabel.setJustificationType(juce::Justification::centredLeft);
+    addAndMakeVisible(cpuLabel);
+
+    csvButton.setTooltip("Save the recent processBlock timings as a CSV file in your Documents folder");
+    csvButton.onClick = [this]                                                                                   //Dump the timing history to a CSV file
+    {
+        auto& monitor = audioProcessor.getPerformanceMonitor();
+        monitor.update();
+
+        auto file = juce::File::getSpecialLocation(juce::File::userDocumentsDirectory)
+                        .getNonexistentChildFile("TENNISBOY timings " + juce::Time::getCurrentTime().formatted("%Y-%m-%d %H-%M-%S"), ".csv");
+
+        if (monitor.writeCSV(file))
+            file.revealToUser();
+    };
+    addAndMakeVisible(csvButton);
+
+    addAndMakeVisible(tapVisualiser);
+
+    //Labels never change, so they're cached rather than re-rendering their text whenever a knob next to them moves
+    for (auto* label : { &delayTimeLabel, &feedbackLabel, &wetDryLabel, &lpfLabel, &qLabel, &qualityLabel, &tapsLabel, &wowLabel, &flutterLabel, &oversamplingLabel, &automationLabel, &transitionLabel })
+        label->setBufferedToImage(true);
+
+    startTimerHz(10); //CPU meter refresh rate
+
+
+
+   
+}
+
+TableTennisAudioProcessorEditor::~TableTennisAudioProcessorEditor()
+{
+    stopTimer();
+}
+
+//==============================================================================
+void TableTennisAudioProcessorEditor::paint(juce::Graphics& g)
+{
+    //Just blits the cached background - a knob being dragged only repaints the area behind that knob
+    auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+
+    if (backgroundImage.isNull() || scale != backgroundScale)
+        drawBackground(scale);
+
+    g.drawImage(backgroundImage, getLocalBounds().toFloat());
+}
+
+void TableTennisAudioProcessorEditor::drawBackground(float scale)
+{
+    //Drawn at the display's pixel scale so the text stays sharp on high DPI screens
+    backgroundScale = scale;
+    backgroundImage = juce::Image(juce::Image::RGB, juce::jmax(1, juce::roundToInt(getWidth() * scale)),
+                                  juce::jmax(1, juce::roundToInt(getHeight() * scale)), false);
+
+    juce::Graphics g(backgroundImage);
+    g.addTransform(juce::AffineTransform::scale(scale));
+
+    {
+        //Set up Graphics characteristics
+
+
+        g.fillAll(juce::Colours::grey); // Fill colour - Grey
+        g.setColour(juce::Colours::white); // Text colour - White
+        g.setFont(20); // Font Size
+        g.drawFittedText("TENNISBOY jr", 80, 30, 250, 15, juce::Justification::centred, 1, 1.0f); //Draw title Text
+        g.setFont(18); // Font Size
+    	g.drawFittedText("Effect LPF", 120, 230, 150, 10, juce::Justification::centred, 1, 1.0f); // Draw LPF title text
+        g.setFont(15); // Font Size
+    	g.drawFittedText("loudtoys", 5, 10, 80, 5, juce::Justification::centred, 1, 1.0f);
+        g.setFont(10); // Font Size
+        g.drawFittedText("Scamalogue Echo Processor", 250, 10, 150, 5, juce::Justification::centred, 1, 1.0f);
+        g.setFont(12); // Font Size
+        g.drawFittedText("Taps L/R", 10, 274, 80, 10, juce::Justification::centred, 1, 1.0f); // Visualiser title
+    }
+}
+
+void TableTennisAudioProcessorEditor::resized()
+{
+    //Positioning of Sub-components, (x, y, width, height)
+
+    delayTimeSlider.setBounds(50, 85, 120, 120);
+    feedbackSlider.setBounds(150, 85, 120, 120);
+    wetDrySlider.setBounds(250, 85, 120, 120);
+    lpfSlider.setBounds(100, 280, 80, 80);
+    qSlider.setBounds(200, 280, 80, 80);
+    qualityBox.setBounds(295, 310, 95, 22);
+    tapsBox.setBounds(295, 255, 95, 22);
+    pingPongButton.setBounds(295, 340, 95, 22);
+    loopFilterButton.setBounds(10, 235, 100, 22);
+    tapVisualiser.setBounds(10, 290, 80, 70);
+    wowSlider.setBounds(100, 385, 80, 70);
+    flutterSlider.setBounds(200, 385, 80, 70);
+    automationBox.setBounds(295, 410, 95, 22);
+    oversamplingBox.setBounds(10, 410, 80, 22);
+    longDelayButton.setBounds(10, 470, 90, 22);
+    longTimeSlider.setBounds(100, 470, 190, 22);
+    freezeButton.setBounds(295, 470, 95, 22);
+    syncButton.setBounds(10, 520, 60, 22);
+    divisionBox.setBounds(75, 520, 105, 22);
+    transitionBox.setBounds(295, 520, 95, 22);
+
+    backgroundImage = {}; //Redrawn at the new size on the next paint
+    cpuLabel.setBounds(5, 550, 340, 20);
+    csvButton.setBounds(350, 550, 45, 20);
+}
+
+void TableTennisAudioProcessorEditor::updateAutomationBox()
+{
+    auto index = TableTennisAudioProcessor::getAutomationGranularities().indexOf(audioProcessor.getAutomationGranularity());
+    automationBox.setSelectedId(index + 1, juce::dontSendNotification); //A setting that isn't in the list (from the renderer, say) shows as nothing selected
+}
+
+void TableTennisAudioProcessorEditor::updateSyncControls()
+{
+    auto synced = syncButton.getToggleState();
+    delayTimeSlider.setEnabled(! synced);
+    divisionBox.setEnabled(synced);
+
+    auto bpm = audioProcessor.getHostBpm();
+    divisionBox.setTooltip(juce::String(TempoSync::getDelayMs(divisionBox.getSelectedItemIndex(), bpm), 1) + " mS at " + juce::String(bpm, 1) + " BPM");
+}
+
+void TableTennisAudioProcessorEditor::timerCallback()
+{
+    updateAutomationBox(); //Catches a state being loaded while the editor's open
+    updateSyncControls(); //And the host's tempo changing
+    //Drain the timing FIFO and show how much of each block's real-time deadline processBlock is using
+    auto& monitor = audioProcessor.getPerformanceMonitor();
+    monitor.update();
+    auto stats = monitor.getStats();
+
+    if (stats.numBlocks == 0)
+        return;
+
+    auto text = "CPU min " + juce::String(stats.minLoad * 100.0, 1)
+              + "%  mean " + juce::String(stats.meanLoad * 100.0, 1)
+              + "%  p99 " + juce::String(stats.p99Load * 100.0, 1)
+              + "%  " + juce::String(stats.meanNanosecondsPerSample, 0) + " ns/smp"
+              + "  overruns " + juce::String(stats.overruns);
+
+    cpuLabel.setText(text, juce::dontSendNotification);
+    cpuLabel.setTooltip("Delay kernels built for " + juce::String(SimdKernels::getName(audioProcessor.getKernelIsa()))); //Which instruction set prepareToPlay picked
+}
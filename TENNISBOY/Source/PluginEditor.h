@@ -1,57 +1,127 @@
-/*
-  ==============================================================================
-
-    This file contains the basic framework code for a JUCE plugin editor.
-
-  ==============================================================================
-*/
-
-#pragma once
-
-#include <JuceHeader.h>
-#include "PluginProcessor.h"
-
-//==============================================================================
-/**
-*/
-class TableTennisAudioProcessorEditor : public juce::AudioProcessorEditor
-{
-public:
-    TableTennisAudioProcessorEditor(TableTennisAudioProcessor&, juce::AudioProcessorValueTreeState&);
-    ~TableTennisAudioProcessorEditor() override;
-
-	//==============================================================================
-
-    void paint(juce::Graphics&) override;
-    void resized() override;
-
-private:
-
-    //Declare Audio Processor and Value Tree
-    TableTennisAudioProcessor& audioProcessor;
-    juce::AudioProcessorValueTreeState& treeState; 
-
-    //Declare Slider objects for each parameter
-    juce::Slider delayTimeSlider;
-    juce::Slider feedbackSlider;
-    juce::Slider wetDrySlider;
-	juce::Slider lpfSlider;
-	juce::Slider qSlider;
-
-    //Declare Labels for each parameter
-    juce::Label delayTimeLabel;
-    juce::Label feedbackLabel;
-    juce::Label wetDryLabel;
-    juce::Label lpfLabel;
-    juce::Label qLabel;
-
-    //Declare Unique Pointers for each parameter
-    std::unique_ptr <juce::AudioProcessorValueTreeState::SliderAttachment> delayTimeValue;
-    std::unique_ptr <juce::AudioProcessorValueTreeState::SliderAttachment> feedbackValue;
-    std::unique_ptr <juce::AudioProcessorValueTreeState::SliderAttachment> wetDryValue;
-    std::unique_ptr <juce::AudioProcessorValueTreeState::SliderAttachment> lpfValue;
-    std::unique_ptr <juce::AudioProcessorValueTreeState::SliderAttachment> qValue;
-
-
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TableTennisAudioProcessorEditor)
-};
+/*
+  ==============================================================================
+
+    This file contains the basic framework code for a JUCE plugin editor.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "TapVisualiser.h"
+
+//==============================================================================
+/**
+*/
+class TableTennisAudioProcessorEditor : public juce::AudioProcessorEditor,
+    private juce::Timer
+{
+public:
+    TableTennisAudioProcessorEditor(TableTennisAudioProcessor&, juce::AudioProcessorValueTreeState&);
+    ~TableTennisAudioProcessorEditor() override;
+
+	//==============================================================================
+
+    void paint(juce::Graphics&) override;
+    void resized() override;
+
+    void timerCallback() override; // Refreshes the CPU meter
+
+private:
+    void drawBackground(float scale); //Renders the static title text into backgroundImage
+
+    //Declare Audio Processor and Value Tree
+    TableTennisAudioProcessor& audioProcessor;
+    juce::AudioProcessorValueTreeState& treeState; 
+
+    //Declare Slider objects for each parameter
+    juce::Slider delayTimeSlider;
+    juce::Slider feedbackSlider;
+    juce::Slider wetDrySlider;
+	juce::Slider lpfSlider;
+	juce::Slider qSlider;
+
+    //Declare Labels for each parameter
+    juce::Label delayTimeLabel;
+    juce::Label feedbackLabel;
+    juce::Label wetDryLabel;
+    juce::Label lpfLabel;
+    juce::Label qLabel;
+
+    //Declare Unique Pointers for each parameter
+    std::unique_ptr <juce::AudioProcessorValueTreeState::SliderAttachment> delayTimeValue;
+    std::unique_ptr <juce::AudioProcessorValueTreeState::SliderAttachment> feedbackValue;
+    std::unique_ptr <juce::AudioProcessorValueTreeState::SliderAttachment> wetDryValue;
+    std::unique_ptr <juce::AudioProcessorValueTreeState::SliderAttachment> lpfValue;
+    std::unique_ptr <juce::AudioProcessorValueTreeState::SliderAttachment> qValue;
+
+    //Delay interpolation type (None/Linear/Lagrange3/Thiran)
+    juce::ComboBox qualityBox;
+    juce::Label qualityLabel;
+    std::unique_ptr <juce::AudioProcessorValueTreeState::ComboBoxAttachment> qualityValue;
+
+    //Tap pattern (Classic/Dotted/Triplet/Spread/Cascade)
+    juce::ComboBox tapsBox;
+    juce::Label tapsLabel;
+    std::unique_ptr <juce::AudioProcessorValueTreeState::ComboBoxAttachment> tapsValue;
+
+    //Ping-pong switch - repeats move round the channels instead of staying put
+    juce::ToggleButton pingPongButton{ "Ping-pong" };
+    std::unique_ptr <juce::AudioProcessorValueTreeState::ButtonAttachment> pingPongValue;
+
+    //LPF placement - on the input, or inside the feedback loop with a soft clip
+    juce::ToggleButton loopFilterButton{ "LPF in loop" };
+    std::unique_ptr <juce::AudioProcessorValueTreeState::ButtonAttachment> loopFilterValue;
+
+    //Tape wobble - slow wow and fast flutter on the delay time
+    juce::Slider wowSlider;
+    juce::Slider flutterSlider;
+    juce::Label wowLabel;
+    juce::Label flutterLabel;
+    std::unique_ptr <juce::AudioProcessorValueTreeState::SliderAttachment> wowValue;
+    std::unique_ptr <juce::AudioProcessorValueTreeState::SliderAttachment> flutterValue;
+
+    //LPF oversampling (Off/2x/4x)
+    juce::ComboBox oversamplingBox;
+    juce::Label oversamplingLabel;
+    std::unique_ptr <juce::AudioProcessorValueTreeState::ComboBoxAttachment> oversamplingValue;
+
+    //Long delay / looper - up to a minute, and freeze to loop what it holds
+    juce::ToggleButton longDelayButton{ "Long delay" };
+    juce::Slider longTimeSlider;
+    juce::ToggleButton freezeButton{ "Freeze" };
+    std::unique_ptr <juce::AudioProcessorValueTreeState::ButtonAttachment> longDelayValue;
+    std::unique_ptr <juce::AudioProcessorValueTreeState::SliderAttachment> longTimeValue;
+    std::unique_ptr <juce::AudioProcessorValueTreeState::ButtonAttachment> freezeValue;
+
+    //Tempo sync - the delay time from the host tempo and a note division, and whether a new time glides or crossfades
+    juce::ToggleButton syncButton{ "Sync" };
+    juce::ComboBox divisionBox;
+    juce::ComboBox transitionBox;
+    juce::Label transitionLabel;
+    std::unique_ptr <juce::AudioProcessorValueTreeState::ButtonAttachment> syncValue;
+    std::unique_ptr <juce::AudioProcessorValueTreeState::ComboBoxAttachment> divisionValue;
+    std::unique_ptr <juce::AudioProcessorValueTreeState::ComboBoxAttachment> transitionValue;
+    void updateSyncControls(); //Greys out whichever of the delay time and division isn't in use, and shows the synced time
+
+    //Automation resolution - not a parameter, it's saved with the state but never automated or changed by a preset
+    juce::ComboBox automationBox;
+    juce::Label automationLabel;
+    void updateAutomationBox(); //Shows the processor's current setting
+
+    //CPU meter - processBlock timings pulled from the processor's lock-free PerformanceMonitor
+    juce::Label cpuLabel;
+    juce::TextButton csvButton{ "CSV" };
+
+    //L/R tap levels, repainted on its own 30Hz timer
+    TapVisualiser tapVisualiser;
+
+    //Everything paint() would draw that never changes. Rebuilt only on resize or a change of display scale
+    juce::Image backgroundImage;
+    float backgroundScale = 0.0f;
+
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TableTennisAudioProcessorEditor)
+};
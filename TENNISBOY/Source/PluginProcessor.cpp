@@ -1,386 +1,801 @@
-/*
-  ==============================================================================
-
-    This file contains the basic framework code for a JUCE plugin processor.
-
-  ==============================================================================
-*/
-
-#include "PluginProcessor.h"
-#include "PluginEditor.h"
-
-//==============================================================================
-TableTennisAudioProcessor::TableTennisAudioProcessor()
-#ifndef JucePlugin_PreferredChannelConfigurations
-    : AudioProcessor(BusesProperties()
-#if ! JucePlugin_IsMidiEffect
-#if ! JucePlugin_IsSynth
-        .withInput("Input", juce::AudioChannelSet::stereo(), true)
-#endif
-        .withOutput("Output", juce::AudioChannelSet::stereo(), true)
-#endif
-    ), treeState(*this, nullptr, juce::Identifier("PARAMETERS"),
-        { std::make_unique<juce::AudioParameterFloat>("delayTime", "Delay (samples)", 0.f, 3000.f, 1000.f),
-          std::make_unique<juce::AudioParameterFloat>("feedback", "Feedback 0-1", 0.f, 0.99f, 0.3f),
-         std::make_unique<juce::AudioParameterFloat>("wetDry", "Mix 0-1", 0.f, 1.0f, 0.3f),
-        	std::make_unique<juce::AudioParameterFloat>("lpf", "frequency",  juce::NormalisableRange<float>(20.0f,20000.0f,1.0f, 0.35f), 600.f),
-            std::make_unique<juce::AudioParameterFloat>("Q", "resonance", 0.1f, 15.f, 1.0f)
-        }), lowPassFilter(juce::dsp::IIR::Coefficients  <float>::makeLowPass(44100, 600.f, 1.f)) //LPF
-#endif
-
-    //Value Tree instantiated. 5 Parameters created - delayTime, feedback, wetDry, lpf and Q. Each with a value range set and initial values specified.
-    //lpf frequency has a normalized range, skewed towards emphasis of lower frequencies, this mimics the logarithmic nature of human frequency perception.
-	//LPF is instantiated here also with initial values.
-
-{
-    const juce::StringArray params = { "delayTime", "feedback", "wetDry"}; // Array is created with first three parameter tags. LPF are read as raw data straight from the tree
-    for (int i = 0; i <= 2; ++i) // increments through array
-    {
-        treeState.addParameterListener(params[i], this);  // Assigns a listener to the first 3 params 
-    }
-}
-TableTennisAudioProcessor::~TableTennisAudioProcessor()
-{
-}
-
-//==============================================================================
-const juce::String TableTennisAudioProcessor::getName() const
-{
-    return JucePlugin_Name;
-}
-
-bool TableTennisAudioProcessor::acceptsMidi() const
-{
-#if JucePlugin_WantsMidiInput
-    return true;
-#else
-    return false;
-#endif
-}
-
-bool TableTennisAudioProcessor::producesMidi() const
-{
-#if JucePlugin_ProducesMidiOutput
-    return true;
-#else
-    return false;
-#endif
-}
-
-bool TableTennisAudioProcessor::isMidiEffect() const
-{
-#if JucePlugin_IsMidiEffect
-    return true;
-#else
-    return false;
-#endif
-}
-
-double TableTennisAudioProcessor::getTailLengthSeconds() const
-{
-    return 0.0;
-}
-
-int TableTennisAudioProcessor::getNumPrograms()
-{
-    return 1;  
-}
-
-int TableTennisAudioProcessor::getCurrentProgram()
-{
-    return 0;
-}
-
-void TableTennisAudioProcessor::setCurrentProgram(int index)
-{
-}
-
-const juce::String TableTennisAudioProcessor::getProgramName(int index)
-{
-    return {};
-}
-
-void TableTennisAudioProcessor::changeProgramName(int index, const juce::String& newName)
-{
-}
-
-//==============================================================================
-void TableTennisAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
-{
-    
-
-    juce::dsp::ProcessSpec spec; //set up structure which contains info about context in which func is likely to be called
-    spec.sampleRate = sampleRate; //Sample Rate for session specified
-    spec.maximumBlockSize = samplesPerBlock; // Maximum no. samples which will be in a block sent to process
-    spec.numChannels = getTotalNumOutputChannels(); //no. output channels
-
-    mDelayLineL.reset(); //resets the mDelayLineL Variable
-    mDelayLineL.prepare(spec);
-
-    mDelayLineR.reset(); //resets the mDelayLineR Variable
-    mDelayLineR.prepare(spec);
-
-    lowPassFilter.reset(); // Resets LPF Variable
-    lowPassFilter.prepare(spec);
-}
-
-void TableTennisAudioProcessor::releaseResources()
-{
-
-}
-
-#ifndef JucePlugin_PreferredChannelConfigurations
-bool TableTennisAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts) const
-{
-#if JucePlugin_IsMidiEffect
-    juce::ignoreUnused(layouts);
-    return true;
-#else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-        && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
-        return false;
-
-    // This checks if the input layout matches the output layout
-#if ! JucePlugin_IsSynth
-    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
-        return false;
-#endif
-
-    return true;
-#endif
-}
-#endif
-//LPF
-void TableTennisAudioProcessor::updateFilter() // This function is called by the process block to continually check for changed in the LPF parameter
-{
-    float freq = *treeState.getRawParameterValue("lpf"); // create float variable - get lpf frequency as a Raw value from the Value Tree
-	float res = *treeState.getRawParameterValue("Q");// create float variable - get lpf resonance as a Raw value from the Value Tree
-
-  
-
-    *lowPassFilter.state = *juce::dsp::IIR::Coefficients <float> ::makeLowPass(44100, freq, res);
-
-	//Update the LPF state with the values in the freq and res variables^^
-}
-
-void TableTennisAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
-{
-    juce::ScopedNoDenormals noDenormals;
-    auto totalNumInputChannels = getTotalNumInputChannels();
-    auto totalNumOutputChannels = getTotalNumOutputChannels();
-
-    
-    for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
-        buffer.clear(i, 0, buffer.getNumSamples());
-
-    dryBuffer.makeCopyOf(buffer); // Create a copy of the audio buffer and store in the dryBuffer. This will be summed at the end of the process block to create a wet/dry mix
-
-    //Low Pass Filter
-    //This acts on the audio buffer, hence creating the copy of the dry signal to sum at the end of the process block.
-    
-		juce::dsp::AudioBlock <float> block(buffer);                                 //Create an AudioBlock and fill with the contents of the Audio buffer
-		updateFilter();                                                                //call the updateFilter function to update the parameter values in the LPF
-		lowPassFilter.process(juce::dsp::ProcessContextReplacing <float>(block));   //Capture context data for the LPF as to where in the block is currently being processed
-
-
-
-    //Delay Processing
-    for (int channel = 0; channel < 2; ++channel) //Cycle through the 2 channels
-    
-    {
-
-        //L Channel
-        if (channel == 0)
-        {
-            auto* channelData = buffer.getWritePointer(channel); // store where buffer write pointer is
-
-            
-
-
-            for (int i = 0; i < buffer.getNumSamples(); i++) //increment through all samples in buffer
-            {
-
-
-            	float in = channelData[i];
-            	// assign unaffected current buffer sample to local variable: in
-
-            	float temp = mDelayLineL.popSample(channel, mDelayTime, false);
-            	// take one sample from the left delay line, delayed by DT1 and stored in local variable: temp
-
-            	float temp2 = mDelayLineL.popSample(channel, mDelayTime2, true);
-                // take another sample from the left delay line, delayed by DT2 and store in local variable: temp2
-
-            	mDelayLineL.pushSample(channel, in + (temp * mFeedback));
-                //Push a sample into the LEFT Delay Line. The sample is the sum of the unaffected sample (in) with the first delayed sample (temp), multiplied by the Feedback modifier (mFeedback)
-
-            	mDelayLineR.pushSample(channel, (temp2 * mFeedback));
-                //Push a sample into the RIGHT Delay Line. The sample is the second delayed sample (temp2), multiplied by the Feedback modifier (mFeedback). Note: no unaffected signal.
-                //This creates the "cross pollinating" Ping-Pong Effect
-
-
-
-                channelData[i] = (temp * sin(mWetDry * 1.5708));
-                //The Current sample in the channel Data is replaced with the contents of the temp variable, multiplied by the wet/Dry value.
-                // The sin function is one half of an equal power crossfade calculation. The other cos portion of the calculation takes place
-                // at the end of the process block, as the dry signal is mixed in again from the dryBuffer. this allows for the LPF to only affect the Wet signal.
-            }
-            
-        }
-
-
-
-
-        
-        //R Channel
-        //the reciprocal mirror image process to the L channel has been repeated for the R channel. The cross pollination on the Delay Lines is reversed,
-        //with DT1 and DT2 swapped, creating a "trippy"space echo -esque ping pong effect. DT1 and DT2 are related to each other by a factor of 0.79
-
-        else if (channel == 1)
-        {
-            auto* channelData = buffer.getWritePointer(channel);
-
-
-
-
-            for (int i = 0; i < buffer.getNumSamples(); i++) 
-            {
-
-
-                float in = channelData[i] ; 
-                float temp = mDelayLineR.popSample(channel, mDelayTime2, false); 
-                float temp2 = mDelayLineR.popSample(channel, mDelayTime, true);
-                mDelayLineR.pushSample(channel, in + (temp * mFeedback));
-                mDelayLineL.pushSample(channel, (temp2 * mFeedback));
-            	channelData[i] = (temp * sin(mWetDry * 1.5708)); 
-            }
-        }
-
-        
-   }
-
-	//Sum DRY buffer with WET buffer
-
-	float DryGain = (1 * cos(mWetDry * 1.5708)); // The reciprocal part of the Wet/Dry mix equal power crossfade calculation
-
-    for (int channel = 0; channel < totalNumInputChannels; ++channel) // increment through channels
-    {
-        buffer.addFromWithRamp(channel, 0, dryBuffer.getWritePointer(channel), dryBuffer.getNumSamples(), DryGain , DryGain);
-        //Sum a sample from dryBuffer (copied at beginning of process block) with buffer (wet)
-        //before a dry sample is summed it is multiplied by a flat gain "ramp"
-        //i.e. theDry Gain Value from the Wet/Dry crossfade calculation
-    }
-}
-
-//==============================================================================
-bool TableTennisAudioProcessor::hasEditor() const
-{
-    return true; // (change this to false if you choose to not supply an editor)
-}
-
-
-
-juce::AudioProcessorEditor* TableTennisAudioProcessor::createEditor()
-{
-    return new TableTennisAudioProcessorEditor(*this, treeState);
-}
-
-//==============================================================================
-void TableTennisAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
-{
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
-
-    //Saving State information FUNCTIONALITY INCOMPLETE
-    //Plugin will save and recall state information but unable to display to dials. Avenue for future improvement.
-
-    juce::MemoryOutputStream stream(destData, true);
-
-    //Saves each of the four Delay Params to output stream
-
-    stream.writeFloat(mDelayTime);
-    stream.writeFloat(mDelayTime2);
-    stream.writeFloat(mFeedback);
-    stream.writeFloat(mWetDry);
-
-    
-
-    //stream.writeFloat(*treeState.getRawParameterValue("lpf"));
-
-    //^This was attempted for the Raw Parameter Values, unsuccessfully
-}
-
-void TableTennisAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
-{
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
-    juce::MemoryInputStream stream(data, static_cast<size_t> (sizeInBytes), false);
-
-    // The Values are recalled, but since they are just the float variables created to hold the values,
-    // the dials return to their set initial values on startup
-    //Was unable to use pointers to value tree params.
-
-
-	mDelayTime = stream.readFloat();
-    mDelayTime2 = stream.readFloat();
-    mFeedback = stream.readFloat();
-    mWetDry = stream.readFloat();
-
-
-    //*treeState.getRawParameterValue("lpf") = stream.readFloat();
-
-   //^This was attempted for the Raw Parameter Values, unsuccessfully
-
-
-}
-
-//==============================================================================
-// This creates new instances of the plugin..
-juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
-{
-    return new TableTennisAudioProcessor();
-}
-
-
-void TableTennisAudioProcessor::parameterChanged(const juce::String& parameterID, float newValue)
-
-//Function detects when parameters are changed and which ones are changed
-//sends the new values to the variables set up in the Processor.h
-{
-
-    if (parameterID == "delayTime") // If a change in delayTime param is detected
-
-    {
-        mDelayTime = (newValue * 44.1);
-        //Assigns newValue to mDelayTime variable, *44.1 converts mS into Samples
-        mDelayLineL.setDelay(newValue * 44.1);
-        //newValue sets the DT1
-
-        mDelayTime2 = (newValue * (44.1 * 0.79));
-        mDelayLineR.setDelay(newValue * (44.1 * 0.79));
-        //DT2 is related to DT by a factor of 0.79. This leads to a "trippy" feel from the delay, but somewhat musical,
-        //due to the two taps' mathematical relationship
-        //To create different effects this factor could be changed with a selection box, adding additional functionality
-        //this could be explored in future iterations of the plugin
-        
-    }
-
-    else if (parameterID == "feedback") // If a change to feedback param is detected
-    {
-        mFeedback = newValue;
-        //mFeedbackvalue is changed to newValue
-    }
-
-    else if (parameterID == "wetDry") //If a change to wetDry param is detected
-    {
-        mWetDry = newValue;
-        //m_wet_dry is changed to newValue
-    }
-  
-}
-
-
+/*
+  ==============================================================================
+
+    This file contains the basic framework code for a JUCE plugin processor.
+
+  ==============================================================================
+*/
+
+#include "PluginProcessor.h"
+#include "PluginEditor.h"
+
+//==============================================================================
+TableTennisAudioProcessor::TableTennisAudioProcessor()
+#ifndef JucePlugin_PreferredChannelConfigurations
+    : AudioProcessor(BusesProperties()
+#if ! JucePlugin_IsMidiEffect
+#if ! JucePlugin_IsSynth
+        .withInput("Input", juce::AudioChannelSet::stereo(), true)
+#endif
+        .withOutput("Output", juce::AudioChannelSet::stereo(), true)
+#endif
+    ), treeState(*this, nullptr, juce::Identifier("PARAMETERS"),
+        { std::make_unique<juce::AudioParameterFloat>("delayTime", "Delay (samples)", 0.f, 3000.f, 1000.f),
+          std::make_unique<juce::AudioParameterFloat>("feedback", "Feedback 0-1", 0.f, 0.99f, 0.3f),
+         std::make_unique<juce::AudioParameterFloat>("wetDry", "Mix 0-1", 0.f, 1.0f, 0.3f),
+        	std::make_unique<juce::AudioParameterFloat>("lpf", "frequency",  juce::NormalisableRange<float>(20.0f,20000.0f,1.0f, 0.35f), 600.f),
+            std::make_unique<juce::AudioParameterFloat>("Q", "resonance", 0.1f, 15.f, 1.0f),
+            std::make_unique<juce::AudioParameterChoice>("quality", "Interpolation", DelayInterpolation::getQualityNames(), (int) DelayInterpolation::Quality::linear),
+            std::make_unique<juce::AudioParameterBool>("pingPong", "Ping-pong", false),
+            std::make_unique<juce::AudioParameterChoice>("taps", "Tap pattern", TapPatterns::getNames(), 0),
+            std::make_unique<juce::AudioParameterBool>("loopFilter", "Filter in feedback", false),
+            std::make_unique<juce::AudioParameterFloat>("wow", "Wow 0-1", 0.f, 1.0f, 0.f),
+            std::make_unique<juce::AudioParameterFloat>("flutter", "Flutter 0-1", 0.f, 1.0f, 0.f),
+            std::make_unique<juce::AudioParameterChoice>("oversampling", "LPF oversampling", juce::StringArray { "Off", "2x", "4x" }, 0),
+            std::make_unique<juce::AudioParameterBool>("longDelay", "Long delay", false),
+            std::make_unique<juce::AudioParameterFloat>("longTime", "Long delay (s)", juce::NormalisableRange<float>(0.5f, maxLongDelaySeconds, 0.01f, 0.5f), 8.0f),
+            std::make_unique<juce::AudioParameterBool>("freeze", "Freeze", false),
+            std::make_unique<juce::AudioParameterBool>("sync", "Tempo sync", false),
+            std::make_unique<juce::AudioParameterChoice>("division", "Sync division", TempoSync::getDivisionNames(), TempoSync::defaultDivision),
+            std::make_unique<juce::AudioParameterChoice>("transition", "Time change", TempoSync::getTransitionNames(), (int) TempoSync::Transition::glide)
+        })
+#endif
+
+    //Value Tree instantiated. 18 Parameters created - delayTime, feedback, wetDry, lpf, Q, quality, pingPong, taps, loopFilter, wow, flutter, oversampling, longDelay, longTime, freeze, sync, division and transition. Each with a value range set and initial values specified.
+    //quality picks the delay tap interpolation (None/Linear/Lagrange3/Thiran). Linear is the original sound.
+    //pingPong sends each channel's repeats into the next channel round. Off is the original sound (every channel echoes into itself).
+    //taps picks one of the built in multi-tap tables (see DelayTaps.h). Classic is the original single tap at DT1, DT2 = DT1 * 0.79
+    //loopFilter moves the LPF from the input into the feedback loop, with a soft clip, so each repeat is darker and dirtier than the last. Off is the original sound.
+    //wow and flutter wobble every tap's delay time, slow and fast, like a worn tape transport (see WowFlutter.h). Both at 0 is the original sound.
+    //oversampling runs the input LPF at 2x or 4x the session rate, so high cutoffs with a high Q stay stable and aren't squashed towards Nyquist. Off is the original sound.
+    //longDelay swaps the multi-tap delay for one echo per channel of up to a minute (longTime), and freeze loops whatever that holds. Off is the original sound.
+    //sync takes the delay time (and the long delay time) from the host tempo and a note division instead - straight, dotted or triplet. Off is the original sound.
+    //transition picks how the delay moves to a new time or tempo - Glide sweeps the read heads there, Crossfade fades a second head in over 20mS (see TempoSync.h). Glide is the original sound.
+    //lpf frequency has a normalized range, skewed towards emphasis of lower frequencies, this mimics the logarithmic nature of human frequency perception.
+
+{
+    //Parameters are read straight from the tree as raw atomic values, once per block (see captureParameters)
+    delayTimeParameter = treeState.getRawParameterValue("delayTime");
+    feedbackParameter = treeState.getRawParameterValue("feedback");
+    wetDryParameter = treeState.getRawParameterValue("wetDry");
+    lpfParameter = treeState.getRawParameterValue("lpf");
+    qParameter = treeState.getRawParameterValue("Q");
+    qualityParameter = treeState.getRawParameterValue("quality");
+    pingPongParameter = treeState.getRawParameterValue("pingPong");
+    tapsParameter = treeState.getRawParameterValue("taps");
+    loopFilterParameter = treeState.getRawParameterValue("loopFilter");
+    wowParameter = treeState.getRawParameterValue("wow");
+    flutterParameter = treeState.getRawParameterValue("flutter");
+    oversamplingParameter = treeState.getRawParameterValue("oversampling");
+    longDelayParameter = treeState.getRawParameterValue("longDelay");
+    longTimeParameter = treeState.getRawParameterValue("longTime");
+    freezeParameter = treeState.getRawParameterValue("freeze");
+    syncParameter = treeState.getRawParameterValue("sync");
+    divisionParameter = treeState.getRawParameterValue("division");
+    transitionParameter = treeState.getRawParameterValue("transition");
+}
+TableTennisAudioProcessor::~TableTennisAudioProcessor()
+{
+}
+
+//==============================================================================
+const juce::String TableTennisAudioProcessor::getName() const
+{
+    return JucePlugin_Name;
+}
+
+bool TableTennisAudioProcessor::acceptsMidi() const
+{
+#if JucePlugin_WantsMidiInput
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool TableTennisAudioProcessor::producesMidi() const
+{
+#if JucePlugin_ProducesMidiOutput
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool TableTennisAudioProcessor::isMidiEffect() const
+{
+#if JucePlugin_IsMidiEffect
+    return true;
+#else
+    return false;
+#endif
+}
+
+double TableTennisAudioProcessor::getTailLengthSeconds() const
+{
+    //Time for the repeats to die away below the silence threshold after the input stops - one delay time per repeat,
+    //each repeat feedback times quieter than the last. This is the same point at which processBlock goes idle
+    auto parameters = resolveTempo(captureParameters());
+    if (parameters.longDelay && parameters.freeze)
+        return maxTailSeconds; //A frozen loop never dies away
+
+    auto modulationMs = parameters.wow > 0.0f || parameters.flutter > 0.0f ? WowFlutter::maxDepthMs : 0.0f; //Wow and flutter only ever make the delay longer
+    auto delaySeconds = parameters.longDelay ? (double) parameters.longTimeSeconds : (parameters.delayTimeMs + modulationMs) / 1000.0;
+    auto numRepeats = 1.0;
+
+    if (parameters.feedback > 0.0f)
+        numRepeats += std::ceil(std::log((double) PingPongKernel<float>::silenceThreshold) / std::log((double) parameters.feedback));
+
+    return juce::jmin(maxTailSeconds, delaySeconds * numRepeats);
+}
+
+int TableTennisAudioProcessor::getNumPrograms()
+{
+    return PresetBank::getNumPresets(); //The factory presets in PresetBank.h
+}
+
+int TableTennisAudioProcessor::getCurrentProgram()
+{
+    return currentProgram.load();
+}
+
+void TableTennisAudioProcessor::setCurrentProgram(int index)
+{
+    //Some hosts call this from the audio thread, so the switch itself is only an index stored. The audio thread switches to the preset's
+    //prebuilt snapshot at the start of its next block, crossfading to the new delay time, and the dials catch up on the message thread
+    index = juce::jlimit(0, getNumPrograms() - 1, index);
+    currentProgram = index;
+    pendingProgram = index;
+
+    //The timer that copies it into the parameters only runs while a program is pending. Off the message thread it can't be started
+    //directly, so a message is posted to start it - at most one waiting at a time, and never from inside processBlock
+    if (juce::MessageManager::existsAndIsCurrentThread())
+        startTimerHz(10);
+    else
+        triggerAsyncUpdate();
+}
+
+const juce::String TableTennisAudioProcessor::getProgramName(int index)
+{
+    return PresetBank::get(index).name;
+}
+
+void TableTennisAudioProcessor::changeProgramName(int index, const juce::String& newName)
+{
+}
+
+//==============================================================================
+void TableTennisAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
+{
+    
+
+    juce::dsp::ProcessSpec spec; //set up structure which contains info about context in which func is likely to be called
+    spec.sampleRate = sampleRate; //Sample Rate for session specified
+    spec.maximumBlockSize = samplesPerBlock; // Maximum no. samples which will be in a block sent to process
+    spec.numChannels = getTotalNumOutputChannels(); //no. output channels
+
+    auto parameters = resolveTempo(captureParameters()); //At the last tempo the host reported - the first block picks up any change
+    programInEffect = pendingProgram.load(); //Everything below starts from a pending program's values already, so there's nothing to crossfade from
+    offlineRender = isNonRealtime(); //Some hosts set this before prepareToPlay without going through setNonRealtime
+    renderingOffline = offlineRender.load();
+
+    //Only the engine for the precision the host is going to call processBlock with is prepared, so only it holds any delay memory -
+    //the other one lets go of whatever it had, if the host has switched precision
+    if (getProcessingPrecision() == doublePrecision)
+    {
+        releaseEngine(floatEngine);
+        prepareEngine(doubleEngine, spec, parameters);
+    }
+    else
+    {
+        releaseEngine(doubleEngine);
+        prepareEngine(floatEngine, spec, parameters);
+    }
+
+    currentTapPattern = parameters.tapPattern;
+    currentLongDelay = parameters.longDelay; //Both delays start out empty, so the first block has nothing to reset
+
+    parameterRamps.prepare(sampleRate, samplesPerBlock); //allocates the per-sample ramp arrays. Delay times in samples depend on the sample rate too
+    parameterRamps.reset(parameters);
+    currentDelayTimeMs = parameters.delayTimeMs;
+    programCrossfadePending = false;
+    blockStartParameters = parameters; //Nothing to glide from on the first block
+
+    tapMeter.prepare(sampleRate); // Meter window length depends on the sample rate
+}
+
+template <typename SampleType>
+void TableTennisAudioProcessor::prepareEngine(DelayEngine<SampleType>& engine, const juce::dsp::ProcessSpec& spec, const ParameterSnapshot& parameters)
+{
+    engine.pingPong.prepare(juce::jmax(1, getTotalNumInputChannels()), (int) std::ceil((maxDelayTimeMs + WowFlutter::maxDepthMs) * spec.sampleRate / 1000.0)); //allocates and clears one delay lane per channel - 3000 mS at whatever the session rate is, plus room for wow and flutter
+    engine.pingPong.setTapTable(TapPatterns::get(parameters.tapPattern)); //Also builds the shared pattern tables here rather than on the audio thread
+    kernelIsa = engine.pingPong.getIsa(); //prepare picked the kernels' instruction set from the CPU (or a forced one) - kept for diagnostics
+
+    engine.dryBuffer.setSize(getTotalNumInputChannels(), (int) spec.maximumBlockSize); //presized here so processBlock never has to allocate it
+
+    engine.pingPong.getFeedbackLoop().prepare(spec.sampleRate, engine.pingPong.getNumChannels()); //The in-loop LPF, one lane per delay line
+    engine.pingPong.getModulation().prepare(spec.sampleRate, engine.pingPong.getNumChannels()); //Wow and flutter LFOs, likewise
+    engine.pingPong.getModulation().setDepths(parameters.wow, parameters.flutter);
+    engine.pingPong.getModulation().reset(); //Starts at the current depths rather than gliding up to them
+
+    engine.lowPassFilter.prepare(spec); // LPF picks up the real sample rate here
+    engine.lowPassFilter.setKernels(engine.pingPong.getKernels()); //Its settled loop runs in the same instruction set as the delay kernel
+    updateFilter(parameters);
+    engine.lowPassFilter.reset(); // Resets LPF state and jumps straight to the current lpf/Q values
+    engine.pingPong.getFeedbackLoop().reset(); // Same for the in-loop one
+
+    //Polyphase IIR half-band oversamplers for the input LPF, sized for the longest block. The audio thread picks one per snapshot
+    for (int factorLog2 = 1; factorLog2 <= maxOversampling; ++factorLog2)
+    {
+        auto& oversampler = engine.oversamplers[(size_t) factorLog2 - 1];
+        oversampler = std::make_unique<juce::dsp::Oversampling<SampleType>>((size_t) juce::jmax(1, getTotalNumInputChannels()), (size_t) factorLog2,
+                                                                             juce::dsp::Oversampling<SampleType>::filterHalfBandPolyphaseIIR);
+        oversampler->initProcessing(spec.maximumBlockSize);
+    }
+
+    setOversampling(engine, getOversampling(parameters)); //Starts at the right rate and delay compensation, rather than switching over on the first block
+
+    //Only the page table and a quarter second's reserve are allocated, unless the long delay is already on - then the pages for its current
+    //time too, so it doesn't start with a gap. The reserve records whatever comes straight after it's switched on, before the allocator has woken
+    engine.longDelay.prepare(juce::jmax(1, getTotalNumInputChannels()), (int) std::ceil(maxLongDelaySeconds * spec.sampleRate),
+                             parameters.longDelay ? getLongDelaySamples(parameters) : 0, PagedDelay<SampleType>::getReserveFrames(spec.sampleRate));
+}
+
+void TableTennisAudioProcessor::releaseResources()
+{
+    //Hands every bit of delay memory back until the next prepareToPlay. Hosts release the instances they've deactivated, and in a
+    //big session those would otherwise each keep seconds of delay lines they aren't using
+    releaseEngine(floatEngine);
+    releaseEngine(doubleEngine);
+}
+
+template <typename SampleType>
+void TableTennisAudioProcessor::releaseEngine(DelayEngine<SampleType>& engine)
+{
+    engine.pingPong.release();
+    engine.longDelay.release();
+    engine.dryBuffer.setSize(0, 0); //Also what processBlock checks to see it's not prepared
+
+    for (auto& oversampler : engine.oversamplers)
+        oversampler.reset();
+}
+
+void TableTennisAudioProcessor::setNonRealtime(bool isNonRealtime) noexcept
+{
+    //Bounces get the dearer settings in RenderQuality.h, live playback the cheap ones. Only a flag is stored - every one of those
+    //settings is already allocated for, so the next block just switches over
+    AudioProcessor::setNonRealtime(isNonRealtime);
+    offlineRender = isNonRealtime;
+}
+
+#ifndef JucePlugin_PreferredChannelConfigurations
+bool TableTennisAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts) const
+{
+#if JucePlugin_IsMidiEffect
+    juce::ignoreUnused(layouts);
+    return true;
+#else
+    // Any single bus from mono up to PingPongKernel::maxChannels channels (stereo, LCR, 5.1, 7.1.4 ...) - every channel
+    // gets its own lane in the delay bank.
+    auto outputs = layouts.getMainOutputChannelSet();
+
+    if (outputs.isDisabled() || outputs.size() > PingPongKernel<float>::maxChannels)
+        return false;
+
+    // This checks if the input layout matches the output layout
+#if ! JucePlugin_IsSynth
+    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
+        return false;
+#endif
+
+    return true;
+#endif
+}
+#endif
+//LPF
+void TableTennisAudioProcessor::updateFilter(const ParameterSnapshot& parameters) // This function is called by the process block to continually check for changed in the LPF parameter
+{
+    floatEngine.lowPassFilter.setCutoffFrequency(parameters.lpf);
+    floatEngine.lowPassFilter.setResonance(parameters.q);
+    doubleEngine.lowPassFilter.setCutoffFrequency(parameters.lpf); //Whichever engine isn't running just holds on to the targets
+    doubleEngine.lowPassFilter.setResonance(parameters.q);
+
+    //The same cutoff and Q drive the in-loop filter, whichever place the LPF is in
+    floatEngine.pingPong.getFeedbackLoop().setCutoffFrequency(parameters.lpf);
+    floatEngine.pingPong.getFeedbackLoop().setResonance(parameters.q);
+    doubleEngine.pingPong.getFeedbackLoop().setCutoffFrequency(parameters.lpf);
+    doubleEngine.pingPong.getFeedbackLoop().setResonance(parameters.q);
+
+    //The filter only recalculates its coefficients when these targets actually change, and ramps to them per sample.
+    //Nothing is allocated here, so this is safe to call every block.
+}
+
+ParameterSnapshot TableTennisAudioProcessor::captureParameters() const noexcept
+{
+    //While a program change is pending its preset's prebuilt snapshot stands in for the parameters - a plain copy, nothing parsed or allocated
+    auto program = pendingProgram.load(std::memory_order_acquire);
+
+    if (program >= 0)
+        return PresetBank::get(program).parameters;
+
+    //Each parameter is one atomic load. The audio thread only ever works from this copy, so a value changed by the
+    //message thread (or host automation) mid-block can't tear the block in half
+    ParameterSnapshot parameters;
+    parameters.delayTimeMs = delayTimeParameter->load();
+    parameters.feedback = feedbackParameter->load();
+    parameters.wetDry = wetDryParameter->load();
+    parameters.lpf = lpfParameter->load();
+    parameters.q = qParameter->load();
+    parameters.quality = (DelayInterpolation::Quality) juce::roundToInt(qualityParameter->load()); //Choice index, stored as a float
+    parameters.rotate = pingPongParameter->load() >= 0.5f;
+    parameters.tapPattern = juce::roundToInt(tapsParameter->load()); //Choice index, stored as a float
+    parameters.loopFilter = loopFilterParameter->load() >= 0.5f;
+    parameters.wow = wowParameter->load();
+    parameters.flutter = flutterParameter->load();
+    parameters.oversampling = juce::roundToInt(oversamplingParameter->load()); //Choice index, which is the power of two
+    parameters.longDelay = longDelayParameter->load() >= 0.5f;
+    parameters.longTimeSeconds = longTimeParameter->load();
+    parameters.freeze = freezeParameter->load() >= 0.5f;
+    parameters.sync = syncParameter->load() >= 0.5f;
+    parameters.division = juce::roundToInt(divisionParameter->load()); //Choice index, stored as a float
+    parameters.transition = (TempoSync::Transition) juce::roundToInt(transitionParameter->load()); //Choice index, stored as a float
+    return parameters;
+}
+
+ParameterSnapshot TableTennisAudioProcessor::resolveTempo(ParameterSnapshot parameters) const noexcept
+{
+    //Synced, the division at the host's tempo stands in for both delay times. The knobs' own values are left alone in the tree, so they're
+    //still there (and still saved) for when sync is switched off
+    if (parameters.sync)
+    {
+        auto delayMs = TempoSync::getDelayMs(parameters.division, hostBpm.load(std::memory_order_relaxed));
+        parameters.delayTimeMs = juce::jmin(delayMs, maxDelayTimeMs); //A whole note at under 80 BPM won't fit in the delay lines
+        parameters.longTimeSeconds = juce::jlimit(0.5f, maxLongDelaySeconds, delayMs / 1000.0f);
+    }
+
+    return parameters;
+}
+
+void TableTennisAudioProcessor::updateTempo() noexcept
+{
+    //Hosts that aren't playing (or have no tempo at all) keep the last one they reported
+    if (auto* playHead = getPlayHead())
+    {
+        juce::AudioPlayHead::CurrentPositionInfo position;
+
+        if (playHead->getCurrentPosition(position) && position.bpm > 0.0)
+            hostBpm.store(position.bpm, std::memory_order_relaxed);
+    }
+}
+
+void TableTennisAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer&)
+{
+    processSamples(buffer, floatEngine);
+}
+
+void TableTennisAudioProcessor::processBlock(juce::AudioBuffer<double>& buffer, juce::MidiBuffer&)
+{
+    processSamples(buffer, doubleEngine); //64 bit hosts get the whole delay run in double - no conversion to float and back
+}
+
+template <typename SampleType>
+void TableTennisAudioProcessor::processSamples(juce::AudioBuffer<SampleType>& buffer, DelayEngine<SampleType>& engine)
+{
+    PerformanceMonitor::ScopedBlockTimer blockTimer(performanceMonitor, buffer.getNumSamples(), getSampleRate()); // Times the whole block, wait-free
+    RealtimeSafety::ScopedRealtimeSection realtimeSection; // In checked builds, any allocation or lock from here on is caught
+    juce::ScopedNoDenormals noDenormals;
+    auto totalNumInputChannels = getTotalNumInputChannels();
+    auto totalNumOutputChannels = getTotalNumOutputChannels();
+
+    
+    for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
+        buffer.clear(i, 0, buffer.getNumSamples());
+
+    if (engine.dryBuffer.getNumSamples() == 0)
+        return; // Not prepared yet, or released - there's no delay memory to run
+
+    updateTempo(); //Once per block - the play head's tempo holds for the whole block
+    auto parameters = resolveTempo(captureParameters()); // One snapshot of every parameter - the values to reach by the end of the block
+    renderingOffline = offlineRender.load(std::memory_order_relaxed);
+    auto program = pendingProgram.load(std::memory_order_acquire);
+    auto previousProgram = programInEffect.load(std::memory_order_relaxed);
+
+    if (program >= 0 && program != previousProgram)
+    {
+        //Program change - jump to the new delay time with a short crossfade between the old and new read heads,
+        //rather than gliding the pitch of everything in the delay lines on the way there. applyParameters starts it
+        programCrossfadePending = true;
+    }
+
+    programInEffect.store(program, std::memory_order_relaxed);
+
+    if (program != previousProgram)
+        blockStartParameters = parameters; //New program (or back to the parameters) - switch straight over, don't glide there from the old values
+
+    //Silence fast path - with nothing coming in and every repeat in the delay lines died away, the output would be silence anyway,
+    //so the filter and delay are skipped altogether. Nothing is reset, so the first non-silent block carries on exactly where this left off
+    auto inputPeak = SampleType();
+
+    for (int channel = 0; channel < totalNumInputChannels; ++channel)
+        inputPeak = juce::jmax(inputPeak, buffer.getMagnitude(channel, 0, buffer.getNumSamples()));
+
+    auto delaySilent = parameters.longDelay ? engine.longDelay.isSilent() : engine.pingPong.isSilent(); //A frozen loop of silence is still silence
+
+    if (inputPeak <= (SampleType) PingPongKernel<SampleType>::silenceThreshold && delaySilent)
+    {
+        applyParameters(engine, parameters); //Still picks up switches and the tap pattern, so the next block starts from the right place
+        blockStartParameters = parameters;
+
+        for (int channel = 0; channel < totalNumInputChannels; ++channel)
+            buffer.clear(channel, 0, buffer.getNumSamples());
+
+        return;
+    }
+
+    //Everything processBlock needs was sized in prepareToPlay for samplesPerBlock. If a host sends a longer block than it promised,
+    //it's processed in pieces rather than reallocating on the audio thread.
+    auto maxChunkSize = engine.dryBuffer.getNumSamples();
+
+    //Automation sub-blocks. Hosts only hand over one value per parameter per block, so on a long block a cutoff sweep would move in
+    //big steps. Instead the block is split into sub-blocks of automationGranularity samples, and each one is given the parameters
+    //that far along the way from the last block's values to this one's, re-reading them too in case anything moved meanwhile.
+    //Constant parameters come out exactly the same every sub-block, so the kernel stays on its settled path
+    auto numSamples = buffer.getNumSamples();
+    auto granularity = automationGranularity.load(std::memory_order_relaxed);
+
+    if (renderingOffline)
+        granularity = RenderQuality::getOfflineAutomationGranularity(granularity); //Finer still for a bounce
+    auto subBlockSize = granularity > 0 ? juce::jmin(granularity, numSamples) : numSamples;
+
+    for (int start = 0; start < numSamples; start += subBlockSize)
+    {
+        auto length = juce::jmin(subBlockSize, numSamples - start);
+
+        if (start > 0 && pendingProgram.load(std::memory_order_acquire) == program) // A program picked mid-block waits for the next one
+            parameters = resolveTempo(captureParameters());
+
+        applyParameters(engine, ParameterSnapshot::interpolate(blockStartParameters, parameters, (float) (start + length) / (float) numSamples));
+
+        for (int chunkStart = start; chunkStart < start + length; chunkStart += maxChunkSize)
+            processChunk(engine, buffer, chunkStart, juce::jmin(maxChunkSize, start + length - chunkStart));
+    }
+
+    blockStartParameters = parameters;
+}
+
+template <typename SampleType>
+void TableTennisAudioProcessor::applyParameters(DelayEngine<SampleType>& engine, const ParameterSnapshot& parameters)
+{
+    updateFilter(parameters);              // call the updateFilter function to update the parameter values in the LPF
+    currentRotate = parameters.rotate;
+    currentLoopFilter = parameters.loopFilter;
+    engine.pingPong.setFeedbackLoopEnabled(currentLoopFilter);
+    engine.pingPong.getFeedbackLoop().setCoefficientsPerFrame(renderingOffline); //Smoother in-loop cutoff sweeps for a bounce
+    engine.pingPong.getModulation().setDepths(parameters.wow, parameters.flutter); //Glides to new depths - at 0 the kernel skips modulation altogether
+
+    auto crossfadeTimes = parameters.transition == TempoSync::Transition::crossfade;
+
+    if (crossfadeTimes && ! engine.pingPong.getModulation().isActive())
+        currentQuality = DelayInterpolation::Quality::none; //The delay only ever jumps, so the taps can be read at whole samples - nothing to interpolate
+    else
+        currentQuality = renderingOffline ? RenderQuality::getOfflineInterpolation(parameters.quality) : parameters.quality;
+
+    if (parameters.tapPattern != currentTapPattern) //Only copies a new table in when the pattern actually changes
+    {
+        engine.pingPong.setTapTable(TapPatterns::get(parameters.tapPattern));
+        currentTapPattern = parameters.tapPattern;
+    }
+
+    auto oversampling = getOversampling(parameters);
+
+    if (oversampling != currentOversampling)
+        setOversampling(engine, oversampling); //Also moves the delays' latency compensation
+
+    auto rampTargets = parameters;
+
+    if (crossfadeTimes || programCrossfadePending)
+    {
+        //A new delay time or tempo - a second head starts at the new time and the two are crossfaded, rather than sweeping the pitch of the repeats.
+        //The second head is only read until the fade is done. One fade at a time: a change that comes in while one is running (a tempo ramp
+        //moves the time every block) waits for it to finish, and then only the latest time is faded to
+        if (parameters.delayTimeMs != currentDelayTimeMs && ! engine.pingPong.isCrossfading())
+        {
+            auto fromDelay = parameterRamps.jumpDelay(parameters);
+            auto seconds = programCrossfadePending ? programCrossfadeSeconds : TempoSync::crossfadeSeconds;
+            engine.pingPong.startCrossfade(fromDelay, juce::roundToInt(seconds * getSampleRate()));
+            currentDelayTimeMs = parameters.delayTimeMs;
+        }
+
+        if (parameters.delayTimeMs == currentDelayTimeMs)
+            programCrossfadePending = false;
+
+        rampTargets.delayTimeMs = currentDelayTimeMs; //Holds the heads where they are until then
+    }
+    else
+    {
+        currentDelayTimeMs = parameters.delayTimeMs;
+    }
+
+    parameterRamps.setTargets(rampTargets); // Delay time, feedback and mix ramp towards the snapshot instead of jumping (no zipper noise)
+
+    if (parameters.longDelay != currentLongDelay)
+    {
+        //Switching between the delays - the one taking over starts empty, rather than replaying whatever it held when it was last
+        //switched off, and its silence check starts from there too
+        if (parameters.longDelay)
+            engine.longDelay.reset(); //Only marks its pages - they're cleared as the write head reaches them
+        else
+            engine.pingPong.reset();
+    }
+
+    currentLongDelay = parameters.longDelay;
+    currentFreeze = parameters.freeze;
+
+    if (currentLongDelay) //A new long delay time crossfades like a program change - gliding a minute of audio would be a long, slow pitch bend
+        engine.longDelay.setDelay(getLongDelaySamples(parameters), juce::roundToInt(programCrossfadeSeconds * getSampleRate()));
+}
+
+int TableTennisAudioProcessor::getOversampling(const ParameterSnapshot& parameters) const noexcept
+{
+    if (parameters.loopFilter && ! parameters.longDelay)
+        return 0; //The input LPF isn't running - nothing to oversample, and no latency to make up for
+
+    return juce::jlimit(0, maxOversampling, renderingOffline ? RenderQuality::getOfflineOversampling(parameters.oversampling) : parameters.oversampling);
+}
+
+int TableTennisAudioProcessor::getLongDelaySamples(const ParameterSnapshot& parameters) const noexcept
+{
+    return juce::jmax(1, juce::roundToInt(parameters.longTimeSeconds * getSampleRate()));
+}
+
+template <typename SampleType>
+void TableTennisAudioProcessor::setOversampling(DelayEngine<SampleType>& engine, int factorLog2)
+{
+    currentOversampling = factorLog2;
+    engine.lowPassFilter.setSampleRate(getSampleRate() * (double) (1 << currentOversampling));
+
+    //The half-band filters delay the wet signal a little on its way into the delay lines. Rather than reporting that as plugin latency,
+    //which would need the dry path delaying to match, both delays output their taps that much sooner. Only the first pass is late - the
+    //feedback never goes through the oversampler - so they still read the feedback at the full delay, and every repeat stays a delay
+    //time after the last. The first echo of a delay shorter than the latency can't come any sooner than the latency
+    auto latency = 0.0f;
+
+    if (auto* oversampler = engine.getOversampler(currentOversampling))
+    {
+        oversampler->reset(); // Don't start from whatever it held the last time it was used
+        latency = (float) oversampler->getLatencyInSamples();
+    }
+
+    engine.pingPong.setLatencyCompensation(latency);
+    engine.longDelay.setLatencyCompensation(juce::roundToInt(latency)); //The long delay only reads whole samples
+}
+
+template <typename SampleType>
+void TableTennisAudioProcessor::processChunk(DelayEngine<SampleType>& engine, juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples)
+{
+    auto& dryBuffer = engine.dryBuffer;
+    auto& pingPong = engine.pingPong;
+
+    auto totalNumInputChannels = getTotalNumInputChannels();
+
+    for (int channel = 0; channel < totalNumInputChannels; ++channel)
+        dryBuffer.copyFrom(channel, 0, buffer, channel, startSample, numSamples);
+    // Copy the audio into the dryBuffer (presized, so this never allocates). This will be summed at the end to create a wet/dry mix
+
+    //Low Pass Filter
+    //This acts on the audio buffer, hence creating the copy of the dry signal to sum at the end.
+
+    //With the filter in the feedback loop instead, the kernel runs it on the repeats and the input goes into the delay untouched.
+    //The long delay always filters its input - except frozen, when the input isn't used at all
+    if (currentLongDelay ? ! currentFreeze : ! currentLoopFilter)
+    {
+        auto block = juce::dsp::AudioBlock<SampleType>(buffer).getSubBlock((size_t) startSample, (size_t) numSamples).getSubsetChannelBlock(0, (size_t) totalNumInputChannels);
+
+        if (auto* oversampler = engine.getOversampler(currentOversampling))
+        {
+            auto upsampled = oversampler->processSamplesUp(block); //Filter at 2x/4x, into the oversampler's own preallocated buffer
+            engine.lowPassFilter.process(upsampled);
+            oversampler->processSamplesDown(block);
+        }
+        else
+        {
+            engine.lowPassFilter.process(block); //Filter the input channels in place
+        }
+    }
+
+
+
+    //Delay Processing
+    //Every channel runs through the fused ping-pong kernel in a single pass. Each sample, every tap in the tap pattern is read from
+    //every channel's delay line at its fraction of the delay time (DT1 on the even channels - L, C, ... - and a fraction of it on the
+    //odd ones, 0.79 for Classic) and the taps are mixed into the wet output. The taps multiplied by the Feedback modifier are added to
+    //the incoming sample and pushed back into that channel's delay line, or with Ping-pong on, into the next channel's, so the
+    //echoes travel round the bus.
+    //The wet gain is one half of an equal power crossfade. The other half is applied as the dry signal is mixed in again from the dryBuffer,
+    //this allows for the LPF to only affect the Wet signal.
+
+    auto numChannels = juce::jmin(totalNumInputChannels, pingPong.getNumChannels());
+
+    if (numChannels == 0)
+        return;
+
+    std::array<SampleType*, PingPongKernel<SampleType>::maxChannels> channels;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        channels[(size_t) channel] = buffer.getWritePointer(channel, startSample);
+
+    auto quality = currentQuality; //The interpolation type is chosen once here - each one is its own specialised kernel, so the per-sample loops never test it
+    auto rotate = currentRotate;
+    auto* meterRight = channels[numChannels > 1 ? 1 : 0]; //The visualiser shows the first two channels (the same one twice for mono)
+
+    if (! parameterRamps.isSmoothing())
+    {
+        //Settled - constant values, gains were worked out once (no sin/cos per sample)
+        auto gains = parameterRamps.getMixGains();
+
+        if (currentLongDelay)
+            engine.longDelay.process(channels.data(), numSamples, parameterRamps.getFeedback(), gains.wet, rotate, currentFreeze);
+        else
+            pingPong.processWithQuality(quality, channels.data(), numSamples, parameterRamps.getDelay(), parameterRamps.getFeedback(), gains.wet, rotate);
+
+        tapMeter.push(channels[0], meterRight, numSamples); // Wet output only, before the dry is mixed back in
+
+        for (int channel = 0; channel < totalNumInputChannels; ++channel) // Sum DRY buffer with WET buffer
+            pingPong.getKernels().addWithGain(buffer.getWritePointer(channel, startSample), dryBuffer.getReadPointer(channel), (SampleType) gains.dry, numSamples);
+
+        return;
+    }
+
+    //Ramping - per-sample values (table lookup for the crossfade gains). The ramp arrays are the same size as the dryBuffer
+    parameterRamps.fill(numSamples);
+
+    if (currentLongDelay)
+        engine.longDelay.process(channels.data(), numSamples, parameterRamps.get(ParameterRamps::feedback),
+                                 parameterRamps.get(ParameterRamps::wetGain), rotate, currentFreeze);
+    else
+        pingPong.processWithQuality(quality, channels.data(), numSamples, parameterRamps.get(ParameterRamps::delay),
+                                    parameterRamps.get(ParameterRamps::feedback), parameterRamps.get(ParameterRamps::wetGain), rotate);
+
+    tapMeter.push(channels[0], meterRight, numSamples);
+
+    auto* dryGain = parameterRamps.get(ParameterRamps::dryGain);
+
+    for (int channel = 0; channel < totalNumInputChannels; ++channel) // Sum DRY buffer with WET buffer
+        pingPong.getKernels().addWithGains(buffer.getWritePointer(channel, startSample), dryBuffer.getReadPointer(channel), dryGain, numSamples);
+}
+
+//==============================================================================
+bool TableTennisAudioProcessor::hasEditor() const
+{
+    return true; // (change this to false if you choose to not supply an editor)
+}
+
+
+
+juce::AudioProcessorEditor* TableTennisAudioProcessor::createEditor()
+{
+    return new TableTennisAudioProcessorEditor(*this, treeState);
+}
+
+//==============================================================================
+void TableTennisAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
+{
+    //Versioned binary state - a "TTBY" header, the version and the current program, then every parameter as a float in its own units,
+    //in ParameterSnapshot's value order, then the automation granularity. Values are only ever appended, so any version reads as many as it knows about
+
+    juce::MemoryOutputStream stream(destData, true);
+
+    stream.writeInt(stateMagic);
+    stream.writeInt(stateVersion);
+    stream.writeInt(currentProgram.load());
+    stream.writeInt(ParameterSnapshot::numValues);
+
+    for (auto value : captureParameters().toValues())
+        stream.writeFloat(value);
+
+    stream.writeInt(automationGranularity.load());
+}
+
+void TableTennisAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
+{
+    // You should use this method to restore your parameters from this memory block,
+    // whose contents will have been created by the getStateInformation() call.
+    if (data == nullptr || sizeInBytes < 16) //Shorter than either layout
+        return;
+
+    juce::MemoryInputStream stream(data, static_cast<size_t> (sizeInBytes), false);
+    auto values = ParameterSnapshot().toValues(); //Anything the state doesn't have goes back to its default
+
+    if (stream.readInt() == stateMagic)
+    {
+        auto version = stream.readInt(); //Every version so far only appends, so there's nothing to convert
+        auto program = stream.readInt();
+        auto numStoredValues = juce::jmax(0, stream.readInt());
+
+        //A truncated or damaged state can claim more values than it holds - only the ones really there are read, the rest keep their defaults
+        auto numValues = juce::jmin(numStoredValues, ParameterSnapshot::numValues, (int) (stream.getNumBytesRemaining() / (juce::int64) sizeof(float)));
+
+        for (int i = 0; i < numValues; ++i)
+            values[(size_t) i] = stream.readFloat();
+
+        stream.skipNextBytes((juce::int64) (numStoredValues - numValues) * (juce::int64) sizeof(float)); //Values from a newer version
+
+        if (version >= 3 && ! stream.isExhausted())
+            setAutomationGranularity(stream.readInt());
+
+        currentProgram = juce::jlimit(0, getNumPrograms() - 1, program);
+    }
+    else
+    {
+        //The original state - four bare floats. DT1 and DT2 in samples at 44.1Khz, then feedback and mix
+        stream.setPosition(0);
+        values[0] = stream.readFloat() / 44.1f;
+        stream.readFloat(); // DT2 always follows DT1
+        values[1] = stream.readFloat();
+        values[2] = stream.readFloat();
+    }
+
+    //The values are recalled through the parameters themselves, so the audio thread picks them up
+    //in its next snapshot and the dials follow too. A program change still waiting is dropped - the state wins
+    pendingProgram = -1;
+
+    for (int i = 0; i < ParameterSnapshot::numValues; ++i)
+        setParameterValue(ParameterSnapshot::parameterIDs[i], values[(size_t) i]);
+}
+
+void TableTennisAudioProcessor::setParameterValue(const juce::String& parameterID, float value)
+{
+    if (auto* parameter = treeState.getParameter(parameterID))
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+}
+
+//==============================================================================
+void TableTennisAudioProcessor::timerCallback()
+{
+    auto program = pendingProgram.load();
+
+    if (program < 0)
+    {
+        programSyncTicks = 0;
+        stopTimer(); //Nothing to do until the next program change
+        return;
+    }
+
+    //Give the audio thread a few ticks to switch to the program first, so the delay time change is crossfaded. If it's not
+    //processing at all, the parameters are updated anyway
+    if (programInEffect.load() != program && ++programSyncTicks < maxProgramSyncTicks)
+        return;
+
+    syncProgramParameters();
+}
+
+void TableTennisAudioProcessor::handleAsyncUpdate()
+{
+    if (pendingProgram.load() >= 0)
+        startTimerHz(10);
+}
+
+void TableTennisAudioProcessor::syncProgramParameters()
+{
+    auto program = pendingProgram.load();
+
+    if (program < 0)
+        return;
+
+    auto values = PresetBank::get(program).parameters.toValues();
+
+    for (int i = 0; i < ParameterSnapshot::numValues; ++i)
+        setParameterValue(ParameterSnapshot::parameterIDs[i], values[(size_t) i]);
+
+    //The parameters hold the preset now, so hand back to them - unless another program was picked meanwhile, which the next tick copies in
+    pendingProgram.compare_exchange_strong(program, -1);
+    programSyncTicks = 0;
+}
+
+//==============================================================================
+// This creates new instances of the plugin..
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
+{
+    return new TableTennisAudioProcessor();
+}
+
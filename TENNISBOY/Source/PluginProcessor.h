@@ -1,81 +1,205 @@
-/*
-  ==============================================================================
-
-    This file contains the basic framework code for a JUCE plugin processor.
-
-  ==============================================================================
-*/
-
-#pragma once
-
-#include <JuceHeader.h>
-
-//==============================================================================
-/**
-*/
-class TableTennisAudioProcessor : public juce::AudioProcessor,
-    public juce::AudioProcessorValueTreeState::Listener
-{
-public:
-    //==============================================================================
-    TableTennisAudioProcessor();
-    ~TableTennisAudioProcessor() override;
-
-    //==============================================================================
-    void prepareToPlay(double sampleRate, int samplesPerBlock) override;
-    void releaseResources() override;
-
-#ifndef JucePlugin_PreferredChannelConfigurations
-    bool isBusesLayoutSupported(const BusesLayout& layouts) const override;
-#endif
-
-    void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
-
-    //==============================================================================
-    juce::AudioProcessorEditor* createEditor() override;
-    bool hasEditor() const override;
-
-    //==============================================================================
-    const juce::String getName() const override;
-
-    bool acceptsMidi() const override;
-    bool producesMidi() const override;
-    bool isMidiEffect() const override;
-    double getTailLengthSeconds() const override;
-
-    //==============================================================================
-    int getNumPrograms() override;
-    int getCurrentProgram() override;
-    void setCurrentProgram(int index) override;
-    const juce::String getProgramName(int index) override;
-    void changeProgramName(int index, const juce::String& newName) override;
-
-    //==============================================================================
-    void getStateInformation(juce::MemoryBlock& destData) override;
-    void setStateInformation(const void* data, int sizeInBytes) override;
-
-    
-    void updateFilter(); //LPF update function declaration
-    
-
-    void parameterChanged(const juce::String& parameterID, float newValue) override; // ParameterChange function declaration
-private:
-    //==============================================================================
-
-    juce::AudioProcessorValueTreeState treeState; // ValueTreeState created
-    juce::dsp::DelayLine<float> mDelayLineL{ 132300 }; //Delay line buffer created for L channel. Init with 1323000 sample buffer (3000 mSeconds at 44.1Khz). Changing this would change the maximum possible delay
-    juce::dsp::DelayLine<float> mDelayLineR{ 132300 }; //The same thing but for R channel
-
-    juce::AudioBuffer<float> dryBuffer; // Create an additional buffer for the dry signal
-
-    //Variables used to hold a copy of the slider values. Initialising values are specified too. LPF values are read as raw values from ValueTree.
-    float mDelayTime = 1000.f;
-    float mDelayTime2 = 2000.0f;
-    float mFeedback = 0.3f;
-    float mWetDry = 0.5f;
-
-    //IIR filter function declared
-    juce::dsp::ProcessorDuplicator<juce::dsp::IIR::Filter<float>, juce::dsp::IIR::Coefficients <float>> lowPassFilter;
-
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TableTennisAudioProcessor)
-};
+/*
+  ==============================================================================
+
+    This file contains the basic framework code for a JUCE plugin processor.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "WetFilter.h"
+#include "PingPongKernel.h"
+#include "PagedDelay.h"
+#include "PerformanceMonitor.h"
+#include "TapMeter.h"
+#include "ParameterSnapshot.h"
+#include "PresetBank.h"
+#include "RenderQuality.h"
+#include "TempoSync.h"
+#include "RealtimeSafety.h"
+
+//==============================================================================
+/**
+*/
+class TableTennisAudioProcessor : public juce::AudioProcessor,
+                                  private juce::Timer,
+                                  private juce::AsyncUpdater
+{
+public:
+    //==============================================================================
+    TableTennisAudioProcessor();
+    ~TableTennisAudioProcessor() override;
+
+    //==============================================================================
+    void prepareToPlay(double sampleRate, int samplesPerBlock) override;
+    void releaseResources() override;
+    void setNonRealtime(bool isNonRealtime) noexcept override; //Switches render quality - see RenderQuality.h
+
+#ifndef JucePlugin_PreferredChannelConfigurations
+    bool isBusesLayoutSupported(const BusesLayout& layouts) const override;
+#endif
+
+    void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock(juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override { return true; }
+
+    //==============================================================================
+    juce::AudioProcessorEditor* createEditor() override;
+    bool hasEditor() const override;
+
+    //==============================================================================
+    const juce::String getName() const override;
+
+    bool acceptsMidi() const override;
+    bool producesMidi() const override;
+    bool isMidiEffect() const override;
+    double getTailLengthSeconds() const override;
+
+    //==============================================================================
+    int getNumPrograms() override;
+    int getCurrentProgram() override;
+    void setCurrentProgram(int index) override;
+    const juce::String getProgramName(int index) override;
+    void changeProgramName(int index, const juce::String& newName) override;
+
+    //==============================================================================
+    void getStateInformation(juce::MemoryBlock& destData) override;
+    void setStateInformation(const void* data, int sizeInBytes) override;
+
+    
+    void updateFilter(const ParameterSnapshot& parameters); //LPF update function declaration
+
+    ParameterSnapshot captureParameters() const noexcept; //Loads every parameter once, atomically - called at the start of each block and automation sub-block
+    ParameterSnapshot resolveTempo(ParameterSnapshot parameters) const noexcept; //Swaps in the synced delay times, at the host's last tempo, if sync is on
+    double getHostBpm() const noexcept { return hostBpm.load(); } //The last tempo the host's play head reported, or TempoSync::defaultBpm
+
+    PerformanceMonitor& getPerformanceMonitor() noexcept { return performanceMonitor; } // processBlock timings, read by the editor's CPU meter
+    TapMeter& getTapMeter() noexcept { return tapMeter; } // Decimated L/R tap levels, read by the editor's visualiser
+    SimdKernels::Isa getKernelIsa() const noexcept { return kernelIsa.load(); } //The instruction set the delay kernels were built for, as picked in the last prepareToPlay
+
+    //Automation resolution - parameters are updated every this many samples within a block, gliding from the last block's values
+    //to this one's. 0 updates them once per block, as hosts deliver them. Any thread, takes effect from the next block
+    static constexpr int defaultAutomationGranularity = 64;
+    static juce::Array<int> getAutomationGranularities() { return { 0, 128, 64, 32 }; } //The editor's choices
+    void setAutomationGranularity(int numSamples) noexcept { automationGranularity = juce::jmax(0, numSamples); }
+    int getAutomationGranularity() const noexcept { return automationGranularity.load(); }
+private:
+    //==============================================================================
+
+    static constexpr int maxOversampling = 2; //Highest input LPF oversampling, as a power of two - 4x
+
+    //The DSP that runs on the audio itself - filter, delay lines and the dry copy for the mix - at one sample precision.
+    //There's one of each, but only the one the host is using is prepared, so only it holds any delay memory
+    template <typename SampleType>
+    struct DelayEngine
+    {
+        PingPongKernel<SampleType> pingPong; //Fused N-channel, multi-tap delay - every channel's delay line shares one interleaved buffer, and every tap of every channel is read in one pass
+        WetFilter<SampleType> lowPassFilter; //Wet path LPF. TPT state variable design - coefficients are only recalculated when lpf/Q move, and no allocation happens on the audio thread
+        juce::AudioBuffer<SampleType> dryBuffer; // Create an additional buffer for the dry signal. Sized in prepareToPlay
+        PagedDelay<SampleType> longDelay; //Long delay and looper, up to maxLongDelaySeconds - memory is allocated off the audio thread, a page at a time, as the delay time asks for it
+
+        //2x and 4x oversampling around the input LPF only - never the dry path. Both are built in prepareToPlay, so switching between them never allocates
+        std::array<std::unique_ptr<juce::dsp::Oversampling<SampleType>>, maxOversampling> oversamplers;
+
+        juce::dsp::Oversampling<SampleType>* getOversampler(int factorLog2) const noexcept //nullptr for no oversampling
+        {
+            return factorLog2 > 0 ? oversamplers[(size_t) juce::jmin(factorLog2, maxOversampling) - 1].get() : nullptr;
+        }
+    };
+
+    void updateTempo() noexcept; //Reads the tempo from the host's play head, if it has one - audio thread only
+
+    void timerCallback() override; //Copies a program picked on the audio thread into the parameters. Only runs while one is pending
+    void handleAsyncUpdate() override; //Starts the timer for a program picked off the message thread
+    void syncProgramParameters(); //Message thread only - writes the pending program's values into the parameters, then hands back to them
+    void setParameterValue(const juce::String& parameterID, float value); //In the parameter's own units, notifying the host
+
+    template <typename SampleType>
+    void prepareEngine(DelayEngine<SampleType>& engine, const juce::dsp::ProcessSpec& spec, const ParameterSnapshot& parameters);
+
+    template <typename SampleType>
+    void releaseEngine(DelayEngine<SampleType>& engine); //Frees its delay lines, oversamplers and dry buffer - prepareEngine builds them again
+
+    template <typename SampleType>
+    void processSamples(juce::AudioBuffer<SampleType>& buffer, DelayEngine<SampleType>& engine); //Both processBlocks end up here
+
+    template <typename SampleType>
+    void applyParameters(DelayEngine<SampleType>& engine, const ParameterSnapshot& parameters); //Hands one snapshot to the ramps, filters and kernel - realtime safe
+
+    int getOversampling(const ParameterSnapshot& parameters) const noexcept; //The input LPF oversampling (as a power of two) a snapshot asks for - offline and loop mode included
+    int getLongDelaySamples(const ParameterSnapshot& parameters) const noexcept; //The long delay time at the session rate, in whole samples
+
+    template <typename SampleType>
+    void setOversampling(DelayEngine<SampleType>& engine, int factorLog2); //Switches the input LPF between the base rate and the prepared oversamplers - realtime safe
+
+    template <typename SampleType>
+    void processChunk(DelayEngine<SampleType>& engine, juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples); //Filter, delay and mix for up to samplesPerBlock samples
+
+    juce::AudioProcessorValueTreeState treeState; // ValueTreeState created
+    static constexpr float maxDelayTimeMs = 3000.0f; //Longest possible delay. The delay buffer is sized from this and the session sample rate in prepareToPlay
+    static constexpr float maxLongDelaySeconds = 60.0f; //Longest long delay. Only the page table is sized from this - the pages come as they're needed
+    static constexpr double maxTailSeconds = 60.0; //Longest tail reported to the host. Near full feedback the real one runs to tens of minutes
+    static constexpr double programCrossfadeSeconds = 0.05; //A program change crossfades to the new delay time over this, instead of gliding to it
+    static constexpr int stateMagic = 0x59425454; //"TTBY" - marks the versioned state. The original state was four bare floats with no header
+    static constexpr int stateVersion = 3; //3 added the automation granularity after the values
+    DelayEngine<float> floatEngine;
+    DelayEngine<double> doubleEngine;
+
+    //Smoothed delay time, feedback and mix, fed from one ParameterSnapshot per block. Replaces the plain floats parameterChanged used to write from the message thread
+    ParameterRamps parameterRamps;
+
+    //Automation sub-blocks - see processSamples. blockStartParameters is where the last block left off (audio thread only)
+    std::atomic<int> automationGranularity { defaultAutomationGranularity };
+    ParameterSnapshot blockStartParameters;
+
+    //Cached pointers to raw parameter values, so captureParameters() doesn't do a string lookup every block
+    std::atomic<float>* delayTimeParameter = nullptr;
+    std::atomic<float>* feedbackParameter = nullptr;
+    std::atomic<float>* wetDryParameter = nullptr;
+    std::atomic<float>* lpfParameter = nullptr;
+    std::atomic<float>* qParameter = nullptr;
+    std::atomic<float>* qualityParameter = nullptr;
+    std::atomic<float>* pingPongParameter = nullptr;
+    std::atomic<float>* tapsParameter = nullptr;
+    std::atomic<float>* loopFilterParameter = nullptr;
+    std::atomic<float>* wowParameter = nullptr;
+    std::atomic<float>* flutterParameter = nullptr;
+    std::atomic<float>* oversamplingParameter = nullptr;
+    std::atomic<float>* longDelayParameter = nullptr;
+    std::atomic<float>* longTimeParameter = nullptr;
+    std::atomic<float>* freezeParameter = nullptr;
+    std::atomic<float>* syncParameter = nullptr;
+    std::atomic<float>* divisionParameter = nullptr;
+    std::atomic<float>* transitionParameter = nullptr;
+
+    std::atomic<double> hostBpm { TempoSync::defaultBpm }; //Written by the audio thread at the start of each block
+    float currentDelayTimeMs = 0.0f; //The delay time last handed to the ramps - a change of it starts a crossfade when the transition is Crossfade
+    bool programCrossfadePending = false; //A program change's delay time is still to be crossfaded to, whatever the transition - see applyParameters
+
+    DelayInterpolation::Quality currentQuality = DelayInterpolation::Quality::linear; //This block's interpolation type, from the snapshot
+    bool currentRotate = false; //This block's ping-pong switch, from the snapshot
+    bool currentLoopFilter = false; //This block's LPF placement - false on the input, true inside the feedback loop
+    bool currentLongDelay = false, currentFreeze = false; //This block's delay - the kernel, or the paged long delay (frozen or not)
+
+    //Offline render quality. Set from whatever thread the host calls setNonRealtime on, picked up by the audio thread at the start of its next block
+    std::atomic<bool> offlineRender { false };
+    bool renderingOffline = false; //This block's copy
+    int currentTapPattern = 0; //The TapPatterns table the kernel is running
+    int currentOversampling = 0; //The input LPF's oversampling right now, as a power of two
+
+    //Program changes. setCurrentProgram only stores the preset's index in pendingProgram, from whatever thread the host calls it on. Until the
+    //message thread has copied that preset into the parameters, the audio thread runs on the preset's prebuilt snapshot instead of the tree
+    std::atomic<int> currentProgram { 0 };
+    std::atomic<int> pendingProgram { -1 }; //-1 when the parameters are in charge
+    std::atomic<int> programInEffect { -1 }; //Written by the audio thread - the pending program it has switched to
+    int programSyncTicks = 0; //Message thread only - timer ticks spent waiting for the audio thread to switch. The timer stops once nothing's pending
+    static constexpr int maxProgramSyncTicks = 5;
+
+    std::atomic<SimdKernels::Isa> kernelIsa { SimdKernels::Isa::scalar }; //Written in prepareToPlay, read by the editor and the renderer
+    PerformanceMonitor performanceMonitor; //Lock-free per-block timing, written by the audio thread
+    TapMeter tapMeter; //Lock-free tap levels, about 60 a second, written by the audio thread
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TableTennisAudioProcessor)
+};
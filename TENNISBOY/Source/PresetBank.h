@@ -0,0 +1,57 @@
+/*
+  ==============================================================================
+
+    PresetBank.h
+
+    The factory presets behind the host's program list. Each one is a
+    ready-made ParameterSnapshot, so switching program on the audio thread is
+    just picking a different snapshot - nothing is parsed or allocated.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ParameterSnapshot.h"
+
+//==============================================================================
+/** One factory preset. */
+struct Preset
+{
+    const char* name;
+    ParameterSnapshot parameters;
+};
+
+//==============================================================================
+namespace PresetBank
+{
+    using Quality = DelayInterpolation::Quality;
+    using Transition = TempoSync::Transition;
+
+    /** Every preset, in program order. Program 0 matches the parameters' defaults. */
+    inline const std::array<Preset, 11>& getPresets() noexcept
+    {
+        //                                          delay    fb     mix    lpf       Q      quality             ping-pong  taps  loop   wow    flutter  oversampling  long   long s  freeze  sync   division  transition
+        static const std::array<Preset, 11> presets {{ { "Default",        { 1000.0f, 0.3f,  0.3f,  600.0f,   1.0f,  Quality::linear,    false,     0,    false,  0.0f,  0.0f,  0,             false, 8.0f,   false,  false, 4,        Transition::glide } },
+                                                       { "Slapback",       { 110.0f,  0.1f,  0.35f, 7000.0f,  0.7f,  Quality::linear,    false,     0,    false,  0.0f,  0.0f,  0,             false, 8.0f,   false,  false, 4,        Transition::glide } },
+                                                       { "Eighth Ping",    { 375.0f,  0.45f, 0.35f, 4000.0f,  0.7f,  Quality::linear,    true,      0,    false,  0.0f,  0.0f,  0,             false, 8.0f,   false,  false, 4,        Transition::glide } },
+                                                       { "Dotted Dub",     { 560.0f,  0.6f,  0.4f,  1200.0f,  2.0f,  Quality::lagrange3, true,      1,    true,   0.0f,  0.0f,  0,             false, 8.0f,   false,  false, 4,        Transition::glide } },
+                                                       { "Triplet Bounce", { 500.0f,  0.35f, 0.3f,  3000.0f,  1.0f,  Quality::linear,    true,      2,    false,  0.0f,  0.0f,  0,             false, 8.0f,   false,  false, 4,        Transition::glide } },
+                                                       { "Wide Spread",    { 800.0f,  0.4f,  0.35f, 5000.0f,  0.8f,  Quality::lagrange3, false,     3,    false,  0.0f,  0.0f,  0,             false, 8.0f,   false,  false, 4,        Transition::glide } },
+                                                       { "Cascade Wash",   { 1500.0f, 0.5f,  0.45f, 2500.0f,  1.0f,  Quality::lagrange3, false,     4,    true,   0.0f,  0.0f,  0,             false, 8.0f,   false,  false, 4,        Transition::glide } },
+                                                       { "Resonant Hit",   { 250.0f,  0.55f, 0.35f, 900.0f,   10.0f, Quality::thiran,    true,      0,    false,  0.0f,  0.0f,  2,             false, 8.0f,   false,  false, 4,        Transition::glide } },
+                                                       { "Worn Tape",      { 420.0f,  0.55f, 0.4f,  2200.0f,  0.9f,  Quality::lagrange3, false,     0,    true,   0.6f,  0.4f,  0,             false, 8.0f,   false,  false, 4,        Transition::glide } },
+                                                       { "Ambient Loop",   { 1000.0f, 0.75f, 0.45f, 3500.0f,  0.7f,  Quality::linear,    true,      0,    false,  0.0f,  0.0f,  0,             true,  6.0f,   false,  false, 4,        Transition::glide } },
+                                                       { "Synced Dotted",  { 1000.0f, 0.45f, 0.35f, 3000.0f,  0.8f,  Quality::linear,    true,      0,    false,  0.0f,  0.0f,  0,             false, 8.0f,   false,  true,  8,        Transition::crossfade } } }};
+        return presets;
+    }
+
+    inline int getNumPresets() noexcept { return (int) getPresets().size(); }
+
+    /** Returns a preset by program index (out of range gives Default). */
+    inline const Preset& get(int index) noexcept
+    {
+        return getPresets()[(size_t) (index >= 0 && index < getNumPresets() ? index : 0)];
+    }
+}
@@ -0,0 +1,272 @@
+/*
+  ==============================================================================
+
+    RealtimeSafety.cpp
+
+  ==============================================================================
+*/
+
+#include "RealtimeSafety.h"
+
+#if TENNISBOY_REALTIME_CHECKS
+
+#include <new>
+#include <cstdlib>
+#include <cerrno>
+
+#if JUCE_LINUX
+ #include <dlfcn.h>
+ #include <pthread.h>
+#endif
+
+namespace RealtimeSafety
+{
+    namespace
+    {
+        thread_local int realtimeDepth = 0;       // > 0 while inside a ScopedRealtimeSection
+        thread_local bool insideHook = false;     // Stops a hook counting the allocations it makes itself
+
+        std::atomic<int> numViolations { 0 };
+        std::atomic<const char*> firstViolation { nullptr };
+
+        /** Suspends checking while a hook calls through to the real allocator. */
+        struct ScopedHook
+        {
+            ScopedHook() noexcept : wasInside(insideHook) { insideHook = true; }
+            ~ScopedHook() noexcept { insideHook = wasInside; }
+            bool wasInside;
+        };
+
+        /** The real allocator behind the aligned forms of new and delete. */
+        void* allocateAligned(std::size_t size, std::size_t alignment) noexcept
+        {
+           #if JUCE_WINDOWS
+            return _aligned_malloc(size == 0 ? 1 : size, alignment);
+           #else
+            void* p = nullptr;
+            return posix_memalign(&p, alignment < sizeof(void*) ? sizeof(void*) : alignment, size == 0 ? 1 : size) == 0 ? p : nullptr;
+           #endif
+        }
+
+        void freeAligned(void* p) noexcept
+        {
+           #if JUCE_WINDOWS
+            _aligned_free(p);
+           #else
+            std::free(p);
+           #endif
+        }
+    }
+
+    int getNumViolations() noexcept             { return numViolations.load(); }
+    const char* getFirstViolation() noexcept    { return firstViolation.load(); }
+
+    void resetViolations() noexcept
+    {
+        numViolations = 0;
+        firstViolation = nullptr;
+    }
+
+    void reportViolation(const char* what) noexcept
+    {
+        if (realtimeDepth == 0 || insideHook)
+            return;
+
+        // No logging or asserting in here - that would allocate. ScopedRealtimeSection asserts once the block is over
+        ++numViolations;
+
+        const char* expected = nullptr;
+        firstViolation.compare_exchange_strong(expected, what);
+    }
+
+    void enterRealtimeSection() noexcept { ++realtimeDepth; }
+    void exitRealtimeSection() noexcept  { --realtimeDepth; }
+}
+
+//==============================================================================
+// Heap allocation through new/delete - every platform. The array, nothrow and
+// sized forms all end up in these two by default.
+
+void* operator new(std::size_t size)
+{
+    RealtimeSafety::reportViolation("operator new");
+
+    void* p;
+
+    {
+        RealtimeSafety::ScopedHook hook;
+        p = std::malloc(size == 0 ? 1 : size);
+    }
+
+    if (p == nullptr)
+        throw std::bad_alloc();
+
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    if (p == nullptr)
+        return;
+
+    RealtimeSafety::reportViolation("operator delete");
+
+    RealtimeSafety::ScopedHook hook;
+    std::free(p);
+}
+
+//==============================================================================
+// The aligned forms (for over-aligned types) allocate on their own, not through the two above. The array, nothrow
+// and sized forms are spelled out as well, rather than trusting the library to route them through these.
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    RealtimeSafety::reportViolation("operator new");
+
+    void* p;
+
+    {
+        RealtimeSafety::ScopedHook hook;
+        p = RealtimeSafety::allocateAligned(size, (std::size_t) alignment);
+    }
+
+    if (p == nullptr)
+        throw std::bad_alloc();
+
+    return p;
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    try
+    {
+        return operator new(size, alignment);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return operator new(size, alignment, std::nothrow);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+    if (p == nullptr)
+        return;
+
+    RealtimeSafety::reportViolation("operator delete");
+
+    RealtimeSafety::ScopedHook hook;
+    RealtimeSafety::freeAligned(p);
+}
+
+void operator delete[](void* p, std::align_val_t alignment) noexcept                            { operator delete(p, alignment); }
+void operator delete(void* p, std::size_t, std::align_val_t alignment) noexcept                 { operator delete(p, alignment); }
+void operator delete[](void* p, std::size_t, std::align_val_t alignment) noexcept               { operator delete(p, alignment); }
+void operator delete(void* p, std::align_val_t alignment, const std::nothrow_t&) noexcept       { operator delete(p, alignment); }
+void operator delete[](void* p, std::align_val_t alignment, const std::nothrow_t&) noexcept     { operator delete(p, alignment); }
+
+//==============================================================================
+// malloc/free and mutexes - glibc lets an executable interpose these directly.
+
+#if JUCE_LINUX
+namespace
+{
+    using LockFunction = int (*) (pthread_mutex_t*);
+    LockFunction realLock = nullptr, realTryLock = nullptr;
+}
+
+extern "C"
+{
+    void* __libc_malloc(size_t);
+    void* __libc_calloc(size_t, size_t);
+    void* __libc_realloc(void*, size_t);
+    void* __libc_memalign(size_t, size_t);
+    void __libc_free(void*);
+
+    void* malloc(size_t size)
+    {
+        RealtimeSafety::reportViolation("malloc");
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t numElements, size_t size)
+    {
+        RealtimeSafety::reportViolation("calloc");
+        return __libc_calloc(numElements, size);
+    }
+
+    void* realloc(void* p, size_t size)
+    {
+        RealtimeSafety::reportViolation("realloc");
+        return __libc_realloc(p, size);
+    }
+
+    void free(void* p)
+    {
+        if (p != nullptr)
+            RealtimeSafety::reportViolation("free");
+
+        __libc_free(p);
+    }
+
+    void* aligned_alloc(size_t alignment, size_t size)
+    {
+        RealtimeSafety::reportViolation("aligned_alloc");
+        return __libc_memalign(alignment, size);
+    }
+
+    void* memalign(size_t alignment, size_t size)
+    {
+        RealtimeSafety::reportViolation("memalign");
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign(void** result, size_t alignment, size_t size)
+    {
+        RealtimeSafety::reportViolation("posix_memalign");
+
+        if (alignment == 0 || alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0)
+            return EINVAL;
+
+        auto* p = __libc_memalign(alignment, size);
+
+        if (p == nullptr)
+            return ENOMEM;
+
+        *result = p;
+        return 0;
+    }
+
+    int pthread_mutex_lock(pthread_mutex_t* mutex)
+    {
+        RealtimeSafety::reportViolation("pthread_mutex_lock");
+
+        if (realLock == nullptr) // Looked up lazily - a function-local static would need a guard, which can take a mutex itself
+            realLock = (LockFunction) dlsym(RTLD_NEXT, "pthread_mutex_lock");
+
+        return realLock(mutex);
+    }
+
+    int pthread_mutex_trylock(pthread_mutex_t* mutex)
+    {
+        RealtimeSafety::reportViolation("pthread_mutex_trylock");
+
+        if (realTryLock == nullptr) // Looked up lazily - a function-local static would need a guard, which can take a mutex itself
+            realTryLock = (LockFunction) dlsym(RTLD_NEXT, "pthread_mutex_trylock");
+
+        return realTryLock(mutex);
+    }
+}
+#endif
+
+#endif
@@ -0,0 +1,74 @@
+/*
+  ==============================================================================
+
+    RealtimeSafety.h
+
+    Catches heap allocations and mutex locks made on the audio thread.
+
+    Only active when TENNISBOY_REALTIME_CHECKS is defined to 1 (debug and test
+    builds of the console targets). Then global operator new/delete are
+    replaced (aligned forms included), and on Linux malloc/calloc/realloc/free,
+    aligned_alloc/posix_memalign/memalign and pthread_mutex_lock/trylock are
+    interposed too. Any of them called while a
+    ScopedRealtimeSection is alive on the calling thread is counted as a
+    violation. With the flag off everything here compiles away to nothing.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#ifndef TENNISBOY_REALTIME_CHECKS
+ #define TENNISBOY_REALTIME_CHECKS 0
+#endif
+
+namespace RealtimeSafety
+{
+    /** True if the allocation/lock hooks are compiled in. */
+    constexpr bool isEnabled() noexcept { return TENNISBOY_REALTIME_CHECKS != 0; }
+
+   #if TENNISBOY_REALTIME_CHECKS
+    /** Number of allocations/locks seen inside a realtime section since the last resetViolations(). */
+    int getNumViolations() noexcept;
+
+    /** Name of the first call that was caught (e.g. "operator new"), or nullptr if there hasn't been one. */
+    const char* getFirstViolation() noexcept;
+
+    void resetViolations() noexcept;
+
+    /** Records a violation if the calling thread is inside a realtime section. Called by the hooks. */
+    void reportViolation(const char* what) noexcept;
+
+    void enterRealtimeSection() noexcept;
+    void exitRealtimeSection() noexcept;
+   #else
+    inline int getNumViolations() noexcept          { return 0; }
+    inline const char* getFirstViolation() noexcept { return nullptr; }
+    inline void resetViolations() noexcept          {}
+   #endif
+
+    //==============================================================================
+    /** Marks the calling thread as realtime for the lifetime of the object - put one at the top of processBlock. */
+    class ScopedRealtimeSection
+    {
+    public:
+       #if TENNISBOY_REALTIME_CHECKS
+        ScopedRealtimeSection() noexcept : violationsAtStart(getNumViolations()) { enterRealtimeSection(); }
+
+        ~ScopedRealtimeSection() noexcept
+        {
+            exitRealtimeSection();
+            jassert(getNumViolations() == violationsAtStart); // Something in processBlock allocated or locked - see getFirstViolation()
+        }
+
+    private:
+        int violationsAtStart;
+       #else
+        ScopedRealtimeSection() noexcept {}
+       #endif
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedRealtimeSection)
+    };
+}
@@ -0,0 +1,44 @@
+/*
+  ==============================================================================
+
+    RenderQuality.h
+
+    What changes when the host renders offline. A bounce isn't racing the
+    audio clock, so it can afford the settings that are too dear for live
+    playback; the processor switches to them whenever isNonRealtime() is set
+    and back again when it isn't.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "DelayInterpolation.h"
+
+//==============================================================================
+namespace RenderQuality
+{
+    /** Automation sub-block size while rendering offline, when the chosen one is coarser (see TableTennisAudioProcessor::setAutomationGranularity). */
+    constexpr int offlineAutomationGranularity = 16;
+
+    /** The interpolation an offline render uses for the chosen one. Linear goes up to Lagrange3 - the same
+        delay, without linear's high frequency droop. None and Thiran are kept, as they're part of the sound.
+    */
+    inline DelayInterpolation::Quality getOfflineInterpolation(DelayInterpolation::Quality chosen) noexcept
+    {
+        return chosen == DelayInterpolation::Quality::linear ? DelayInterpolation::Quality::lagrange3 : chosen;
+    }
+
+    /** The input LPF oversampling (as a power of two) an offline render uses for the chosen one - at least 2x. */
+    inline int getOfflineOversampling(int chosen) noexcept
+    {
+        return juce::jmax(1, chosen);
+    }
+
+    /** The automation sub-block size an offline render uses for the chosen one. */
+    inline int getOfflineAutomationGranularity(int chosen) noexcept
+    {
+        return chosen > 0 ? juce::jmin(chosen, offlineAutomationGranularity) : offlineAutomationGranularity;
+    }
+}
@@ -0,0 +1,117 @@
+/*
+  ==============================================================================
+
+    SimdKernels.cpp
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "SimdKernels.h"
+
+namespace SimdKernels
+{
+    namespace
+    {
+        std::atomic<int> forcedIsa { (int) Isa::numIsas }; // numIsas when nothing's forced
+
+        const Tables* getBuiltTables(Isa isa) noexcept
+        {
+            switch (isa)
+            {
+                case Isa::sse2:     return Detail::getSSE2Tables();
+                case Isa::avx2:     return Detail::getAVX2Tables();
+                case Isa::avx512:   return Detail::getAVX512Tables();
+                case Isa::neon:     return Detail::getNeonTables();
+                case Isa::scalar:
+                case Isa::numIsas:
+                default:            return Detail::getScalarTables();
+            }
+        }
+
+        bool cpuHas(Isa isa) noexcept
+        {
+            switch (isa)
+            {
+                case Isa::scalar:   return true;
+                case Isa::sse2:     return juce::SystemStats::hasSSE2();
+                case Isa::avx2:     return juce::SystemStats::hasAVX2();
+                case Isa::avx512:   return juce::SystemStats::hasAVX512F();
+                case Isa::neon:     return juce::SystemStats::hasNeon();
+                case Isa::numIsas:
+                default:            return false;
+            }
+        }
+
+        Isa fromName(const juce::String& name) noexcept
+        {
+            for (int i = 0; i < (int) Isa::numIsas; ++i)
+                if (name.trim().equalsIgnoreCase(getName((Isa) i)))
+                    return (Isa) i;
+
+            return Isa::numIsas;
+        }
+    }
+
+    //==============================================================================
+    bool isBuilt(Isa isa) noexcept
+    {
+        return isa != Isa::numIsas && getBuiltTables(isa) != nullptr;
+    }
+
+    bool isSupported(Isa isa) noexcept
+    {
+        return isBuilt(isa) && cpuHas(isa);
+    }
+
+    Isa getBestIsa() noexcept
+    {
+        static const auto best = []
+        {
+            for (auto isa : { Isa::avx512, Isa::avx2, Isa::neon, Isa::sse2 }) // Fastest first
+                if (isSupported(isa))
+                    return isa;
+
+            return Isa::scalar;
+        }();
+
+        return best;
+    }
+
+    Isa getPreferredIsa() noexcept
+    {
+        auto forced = (Isa) forcedIsa.load();
+
+        if (forced == Isa::numIsas)
+            forced = fromName(juce::SystemStats::getEnvironmentVariable("TENNISBOY_KERNELS", {}));
+
+        if (forced != Isa::numIsas && isSupported(forced))
+            return forced;
+
+        return getBestIsa(); // Nothing forced, or something this build or CPU doesn't have
+    }
+
+    void forceIsa(Isa isa) noexcept
+    {
+        forcedIsa = (int) isa;
+    }
+
+    const char* getName(Isa isa) noexcept
+    {
+        switch (isa)
+        {
+            case Isa::scalar:   return "scalar";
+            case Isa::sse2:     return "sse2";
+            case Isa::avx2:     return "avx2";
+            case Isa::avx512:   return "avx512";
+            case Isa::neon:     return "neon";
+            case Isa::numIsas:
+            default:            return "";
+        }
+    }
+
+    const Tables& getTables(Isa isa) noexcept
+    {
+        return *getBuiltTables(isSupported(isa) ? isa : Isa::scalar);
+    }
+}
@@ -0,0 +1,143 @@
+/*
+  ==============================================================================
+
+    SimdKernels.h
+
+    The flat inner loops of the delay kernel, the mix and the two state
+    variable filters, built once for each instruction set (plain scalar, SSE2,
+    AVX2, AVX-512 and NEON) and picked at run time from what the CPU has, so
+    one binary is fast on machines both with and without AVX-512.
+
+    Each instruction set has its own translation unit (SimdKernelsAVX2.cpp and
+    so on) that includes SimdKernelsImpl.h under its own target settings. This
+    header is plain C++ on purpose - anything from JuceHeader.h included there
+    could be compiled for AVX and picked by the linker for the whole binary.
+
+    The tap reads are in here too, for every interpolator but Thiran - that one
+    carries each sample's output into the next, so it stays in PingPongKernel
+    one value at a time. PingPongKernel still works out where each tap lands
+    (DelayInterpolation's makeTap()), then hands the loads and the arithmetic
+    over as one flat loop per lane, or one per chunk while the delay moves.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+namespace SimdKernels
+{
+    /** The instruction sets the kernels are built for. */
+    enum class Isa
+    {
+        scalar = 0, // One value at a time, vectorising turned off - the fallback every CPU can run
+        sse2,
+        avx2,
+        avx512,     // AVX-512F
+        neon,
+        numIsas
+    };
+
+    //==============================================================================
+    /** One instruction set's kernels. Spans may be any length and alignment, and mustn't overlap unless they're the same span.
+        Gains arrive as floats, the way ParameterRamps produces them, and are applied at SampleType precision.
+    */
+    template <typename SampleType>
+    struct Table
+    {
+        void (*add)(SampleType* dest, const SampleType* source, int num);                              // dest += source
+        void (*addWithGain)(SampleType* dest, const SampleType* source, SampleType gain, int num);     // dest += source * gain
+        void (*addWithGains)(SampleType* dest, const SampleType* source, const float* gains, int num); // dest += source * gains, per sample
+        void (*multiply)(SampleType* dest, SampleType gain, int num);                                 // dest *= gain
+        void (*multiplyByGains)(SampleType* dest, const float* gains, int num);                       // dest *= gains, per sample
+
+        /** Adds one lane of numFrames interleaved frames (every stride-th value), times gain, onto a planar span. */
+        void (*addFromLane)(SampleType* dest, const SampleType* lane, int stride, SampleType gain, int numFrames);
+
+        /** Writes a planar span into one lane of numFrames interleaved frames. */
+        void (*copyToLane)(SampleType* lane, int stride, const SampleType* source, int numFrames);
+
+        /** FeedbackLoop::softClip over a span, in place. */
+        void (*softClip)(SampleType* data, int num);
+
+        /** Linear crossfade of numFrames interleaved frames, in place in 'to' - frame i takes (position + i + 1) / length of 'to'
+            (capped at 1) and the rest from 'from'. PingPongKernel's two-head crossfade.
+        */
+        void (*crossfade)(SampleType* to, const SampleType* from, int numFrames, int numLanes, int position, int length);
+
+        /** WetFilter's TPT state variable low pass over one channel, in place, on constant coefficients: g, k1 = 1/Q + g and
+            h = 1 / (1 + g k1). z1 and z2 carry the integrator state in and out. Each sample needs the last one's state, so
+            this one can't be vectorised - it's here to run in the same instruction set as everything around it.
+        */
+        void (*svfLowPass)(SampleType* data, int num, SampleType g, SampleType k1, SampleType h, SampleType* z1, SampleType* z2);
+
+        /** FeedbackLoop's low pass - the same filter, over numFrames interleaved frames with a state per lane (z1 and z2
+            point at numLanes values each). It runs across the lanes one frame at a time, so that loop vectorises.
+        */
+        void (*svfLowPassLanes)(SampleType* data, int numFrames, int numLanes, SampleType g, SampleType k1, SampleType h, SampleType* z1, SampleType* z2);
+
+        /** PingPongKernel's tap reads at a constant delay, one for each non-recursive DelayInterpolation policy (None, Linear and
+            Lagrange3). One lane of numFrames interleaved frames, stride values apart: frame i reads its newest point at
+            newest[i * stride] and the older ones a stride apart behind it, and writes out[i * stride]. frac is the tap's
+            fractional position (None ignores it).
+        */
+        void (*readLaneNearest)(SampleType* out, const SampleType* newest, int stride, SampleType frac, int numFrames);
+        void (*readLaneLinear)(SampleType* out, const SampleType* newest, int stride, SampleType frac, int numFrames);
+        void (*readLaneLagrange3)(SampleType* out, const SampleType* newest, int stride, SampleType frac, int numFrames);
+
+        /** The same reads with a delay for every value, while the delay ramps or wobbles: value j reads its newest point at
+            base[offsets[j]], the older ones stride apart behind it, at fracs[j] (None ignores fracs and stride).
+        */
+        void (*readNearestAt)(SampleType* out, const SampleType* base, const int* offsets, const float* fracs, int stride, int num);
+        void (*readLinearAt)(SampleType* out, const SampleType* base, const int* offsets, const float* fracs, int stride, int num);
+        void (*readLagrange3At)(SampleType* out, const SampleType* base, const int* offsets, const float* fracs, int stride, int num);
+    };
+
+    /** One instruction set's kernels at both precisions. */
+    struct Tables
+    {
+        Table<float> floats;
+        Table<double> doubles;
+    };
+
+    //==============================================================================
+    /** True if this build has the kernels for an instruction set (no AVX on ARM, no NEON on x86). */
+    bool isBuilt(Isa isa) noexcept;
+
+    /** True if the kernels are built and this CPU can run them. */
+    bool isSupported(Isa isa) noexcept;
+
+    /** The fastest instruction set this CPU supports. Detected once, on the first call. */
+    Isa getBestIsa() noexcept;
+
+    /** What prepareToPlay should use: a forced instruction set if there is one and the CPU can run it, otherwise getBestIsa().
+        An instruction set can be forced with forceIsa(), or from outside with the TENNISBOY_KERNELS environment variable
+        set to one of the getName() names - forceIsa() wins.
+    */
+    Isa getPreferredIsa() noexcept;
+
+    /** Forces getPreferredIsa() to an instruction set, for testing and benchmarking. Isa::numIsas undoes it. */
+    void forceIsa(Isa isa) noexcept;
+
+    /** "scalar", "sse2", "avx2", "avx512" or "neon". */
+    const char* getName(Isa isa) noexcept;
+
+    /** The kernels for an instruction set, or the scalar ones if this CPU can't run it. */
+    const Tables& getTables(Isa isa) noexcept;
+
+    template <typename SampleType>
+    const Table<SampleType>& getTable(Isa isa) noexcept;
+
+    template <> inline const Table<float>& getTable<float>(Isa isa) noexcept     { return getTables(isa).floats; }
+    template <> inline const Table<double>& getTable<double>(Isa isa) noexcept   { return getTables(isa).doubles; }
+
+    //==============================================================================
+    namespace Detail
+    {
+        // Defined in each instruction set's own .cpp - nullptr where the build can't target it
+        const Tables* getScalarTables() noexcept;
+        const Tables* getSSE2Tables() noexcept;
+        const Tables* getAVX2Tables() noexcept;
+        const Tables* getAVX512Tables() noexcept;
+        const Tables* getNeonTables() noexcept;
+    }
+}
@@ -0,0 +1,43 @@
+/*
+  ==============================================================================
+
+    SimdKernelsAVX2.cpp
+
+    AVX2. GCC and Clang are switched over by the pragmas below. MSVC can only
+    do a whole file at once, so this file gets /arch:AVX2 through the AVX2
+    compiler flag scheme in the .jucer - nothing else may.
+
+  ==============================================================================
+*/
+
+#include "SimdKernels.h"
+
+#if defined (__x86_64__) || defined (_M_X64) || defined (__i386__) || defined (_M_IX86)
+
+#if defined (_MSC_VER) && ! defined (__clang__) && ! defined (__AVX2__)
+ #error "SimdKernelsAVX2.cpp needs /arch:AVX2 - give it the AVX2 compiler flag scheme in the Projucer"
+#endif
+
+#if defined (__clang__)
+ #pragma clang attribute push (__attribute__ ((target ("avx2"))), apply_to = function)
+#elif defined (__GNUC__)
+ #pragma GCC push_options
+ #pragma GCC target ("avx2")
+#endif
+
+#define SIMD_KERNELS_NAMESPACE AVX2
+#include "SimdKernelsImpl.h"
+
+#if defined (__clang__)
+ #pragma clang attribute pop
+#elif defined (__GNUC__)
+ #pragma GCC pop_options
+#endif
+
+const SimdKernels::Tables* SimdKernels::Detail::getAVX2Tables() noexcept { return &AVX2::tables; }
+
+#else
+
+const SimdKernels::Tables* SimdKernels::Detail::getAVX2Tables() noexcept { return nullptr; }
+
+#endif
@@ -0,0 +1,45 @@
+/*
+  ==============================================================================
+
+    SimdKernelsAVX512.cpp
+
+    AVX-512F, on full 512 bit registers. GCC and Clang are switched over by the
+    pragmas below, MSVC by the AVX512 compiler flag scheme (/arch:AVX512) in
+    the .jucer - as for SimdKernelsAVX2.cpp, no other file may have it.
+
+  ==============================================================================
+*/
+
+#include "SimdKernels.h"
+
+#if defined (__x86_64__) || defined (_M_X64)
+
+#if defined (_MSC_VER) && ! defined (__clang__) && ! defined (__AVX512F__)
+ #error "SimdKernelsAVX512.cpp needs /arch:AVX512 - give it the AVX512 compiler flag scheme in the Projucer"
+#endif
+
+// Compilers tuning for generic x64 stop at 256 bit vectors even with AVX-512 on, because of the clock speed
+// drop on older Xeons. These loops are short and memory bound, so the wider registers win
+#if defined (__clang__)
+ #pragma clang attribute push (__attribute__ ((target ("avx512f"), min_vector_width (512))), apply_to = function)
+#elif defined (__GNUC__)
+ #pragma GCC push_options
+ #pragma GCC target ("avx512f", "prefer-vector-width=512")
+#endif
+
+#define SIMD_KERNELS_NAMESPACE AVX512
+#include "SimdKernelsImpl.h"
+
+#if defined (__clang__)
+ #pragma clang attribute pop
+#elif defined (__GNUC__)
+ #pragma GCC pop_options
+#endif
+
+const SimdKernels::Tables* SimdKernels::Detail::getAVX512Tables() noexcept { return &AVX512::tables; }
+
+#else
+
+const SimdKernels::Tables* SimdKernels::Detail::getAVX512Tables() noexcept { return nullptr; }
+
+#endif
@@ -0,0 +1,259 @@
+/*
+  ==============================================================================
+
+    SimdKernelsImpl.h
+
+    The bodies of the SimdKernels. Plain loops, written so the compiler can
+    vectorise them for whatever instruction set the including .cpp targets.
+    No #pragma once - every instruction set's .cpp includes this once, with
+    SIMD_KERNELS_NAMESPACE set to a name of its own so none of the functions
+    can be mistaken for another instruction set's at link time, and the
+    compiler already targeting that instruction set.
+
+    Nothing in here may call out to anything inline from another header (not
+    even std::min), for the same reason. Every loop does exactly the same
+    arithmetic in the same order as the scalar code it replaced, so all the
+    instruction sets give bit-identical results.
+
+  ==============================================================================
+*/
+
+#include "SimdKernels.h"
+
+#ifndef SIMD_KERNELS_NAMESPACE
+ #error "Define SIMD_KERNELS_NAMESPACE before including SimdKernelsImpl.h"
+#endif
+
+#ifndef SIMD_KERNELS_VECTORISE
+ #define SIMD_KERNELS_VECTORISE 1 // 0 for the scalar build
+#endif
+
+// No multiply-adds fused behind our backs (FMA rounds once where the scalar code rounds twice), and vectorising
+// on, whatever the project's optimisation settings - or off, for the scalar build. SIMD_KERNELS_LOOP goes in
+// front of every loop, for the compilers that only take that per loop
+#if defined (__clang__)
+ #pragma clang fp contract (off)
+ #if ! SIMD_KERNELS_VECTORISE
+  #define SIMD_KERNELS_LOOP _Pragma ("clang loop vectorize(disable) interleave(disable)")
+ #endif
+#elif defined (__GNUC__)
+ #if SIMD_KERNELS_VECTORISE
+  #pragma GCC optimize ("tree-vectorize", "vect-cost-model=dynamic", "fp-contract=off")
+ #else
+  #pragma GCC optimize ("no-tree-vectorize", "fp-contract=off")
+ #endif
+#elif defined (_MSC_VER)
+ #pragma fp_contract (off)
+ #if ! SIMD_KERNELS_VECTORISE
+  #define SIMD_KERNELS_LOOP __pragma (loop (no_vector))
+ #endif
+#endif
+
+#ifndef SIMD_KERNELS_LOOP
+ #define SIMD_KERNELS_LOOP
+#endif
+
+namespace SimdKernels
+{
+namespace SIMD_KERNELS_NAMESPACE
+{
+    template <typename SampleType>
+    struct Kernels
+    {
+        static void add(SampleType* dest, const SampleType* source, int num) noexcept
+        {
+            SIMD_KERNELS_LOOP
+            for (int i = 0; i < num; ++i)
+                dest[i] += source[i];
+        }
+
+        static void addWithGain(SampleType* dest, const SampleType* source, SampleType gain, int num) noexcept
+        {
+            SIMD_KERNELS_LOOP
+            for (int i = 0; i < num; ++i)
+                dest[i] += source[i] * gain;
+        }
+
+        static void addWithGains(SampleType* dest, const SampleType* source, const float* gains, int num) noexcept
+        {
+            SIMD_KERNELS_LOOP
+            for (int i = 0; i < num; ++i)
+                dest[i] += source[i] * (SampleType) gains[i];
+        }
+
+        static void multiply(SampleType* dest, SampleType gain, int num) noexcept
+        {
+            SIMD_KERNELS_LOOP
+            for (int i = 0; i < num; ++i)
+                dest[i] *= gain;
+        }
+
+        static void multiplyByGains(SampleType* dest, const float* gains, int num) noexcept
+        {
+            SIMD_KERNELS_LOOP
+            for (int i = 0; i < num; ++i)
+                dest[i] *= (SampleType) gains[i];
+        }
+
+        static void addFromLane(SampleType* dest, const SampleType* lane, int stride, SampleType gain, int numFrames) noexcept
+        {
+            SIMD_KERNELS_LOOP
+            for (int i = 0; i < numFrames; ++i)
+                dest[i] += lane[i * stride] * gain;
+        }
+
+        static void copyToLane(SampleType* lane, int stride, const SampleType* source, int numFrames) noexcept
+        {
+            SIMD_KERNELS_LOOP
+            for (int i = 0; i < numFrames; ++i)
+                lane[i * stride] = source[i];
+        }
+
+        static void softClip(SampleType* data, int num) noexcept
+        {
+            SIMD_KERNELS_LOOP
+            for (int i = 0; i < num; ++i)
+            {
+                auto x = data[i] < (SampleType) -3 ? (SampleType) -3 : ((SampleType) 3 < data[i] ? (SampleType) 3 : data[i]);
+                auto x2 = x * x;
+                data[i] = x * ((SampleType) 27 + x2) / ((SampleType) 27 + (SampleType) 9 * x2);
+            }
+        }
+
+        static void crossfade(SampleType* to, const SampleType* from, int numFrames, int numLanes, int position, int length) noexcept
+        {
+            for (int i = 0; i < numFrames; ++i)
+            {
+                auto proportion = (float) (position + i + 1) / (float) length;
+                auto fadeIn = (SampleType) (proportion < 1.0f ? proportion : 1.0f);
+                auto* frameTo = to + i * numLanes;
+                auto* frameFrom = from + i * numLanes;
+
+                SIMD_KERNELS_LOOP
+                for (int lane = 0; lane < numLanes; ++lane)
+                    frameTo[lane] = frameFrom[lane] + fadeIn * (frameTo[lane] - frameFrom[lane]);
+            }
+        }
+
+        static void svfLowPass(SampleType* data, int num, SampleType g, SampleType k1, SampleType h, SampleType* z1, SampleType* z2) noexcept
+        {
+            auto s1 = *z1, s2 = *z2;
+
+            SIMD_KERNELS_LOOP
+            for (int i = 0; i < num; ++i)
+            {
+                auto hp = (data[i] - k1 * s1 - s2) * h;
+                auto bp = g * hp + s1;
+                s1 = g * hp + bp;
+                auto lp = g * bp + s2;
+                s2 = g * bp + lp;
+                data[i] = lp;
+            }
+
+            *z1 = s1;
+            *z2 = s2;
+        }
+
+        static void svfLowPassLanes(SampleType* data, int numFrames, int numLanes, SampleType g, SampleType k1, SampleType h,
+                                    SampleType* z1, SampleType* z2) noexcept
+        {
+            for (int frame = 0; frame < numFrames; ++frame)
+            {
+                auto* io = data + frame * numLanes;
+
+                SIMD_KERNELS_LOOP
+                for (int lane = 0; lane < numLanes; ++lane)
+                {
+                    auto hp = (io[lane] - k1 * z1[lane] - z2[lane]) * h;
+                    auto bp = g * hp + z1[lane];
+                    z1[lane] = g * hp + bp;
+                    auto lp = g * bp + z2[lane];
+                    z2[lane] = g * bp + lp;
+                    io[lane] = lp;
+                }
+            }
+        }
+
+        // Tap reads. Each one is DelayInterpolation's interpolate(), written out for a whole lane (or a whole chunk) of points
+        static void readLaneNearest(SampleType* out, const SampleType* newest, int stride, SampleType, int numFrames) noexcept
+        {
+            SIMD_KERNELS_LOOP
+            for (int i = 0; i < numFrames; ++i)
+                out[i * stride] = newest[i * stride];
+        }
+
+        static void readLaneLinear(SampleType* out, const SampleType* newest, int stride, SampleType frac, int numFrames) noexcept
+        {
+            SIMD_KERNELS_LOOP
+            for (int i = 0; i < numFrames; ++i)
+            {
+                auto* points = newest + i * stride;
+                out[i * stride] = points[0] + frac * (points[-stride] - points[0]);
+            }
+        }
+
+        static void readLaneLagrange3(SampleType* out, const SampleType* newest, int stride, SampleType frac, int numFrames) noexcept
+        {
+            auto d1 = frac - (SampleType) 1.0;
+            auto d2 = frac - (SampleType) 2.0;
+            auto d3 = frac - (SampleType) 3.0;
+
+            auto c1 = d1 * d2 * d3 * (SampleType) (-1.0 / 6.0);
+            auto c2 = d2 * d3 * (SampleType) 0.5;
+            auto c3 = d1 * d3 * (SampleType) -0.5;
+            auto c4 = d1 * d2 * (SampleType) (1.0 / 6.0);
+
+            SIMD_KERNELS_LOOP
+            for (int i = 0; i < numFrames; ++i)
+            {
+                auto* points = newest + i * stride;
+                out[i * stride] = points[0] * c1 + frac * (points[-stride] * c2 + points[-2 * stride] * c3 + points[-3 * stride] * c4);
+            }
+        }
+
+        static void readNearestAt(SampleType* out, const SampleType* base, const int* offsets, const float*, int, int num) noexcept
+        {
+            SIMD_KERNELS_LOOP
+            for (int j = 0; j < num; ++j)
+                out[j] = base[offsets[j]];
+        }
+
+        static void readLinearAt(SampleType* out, const SampleType* base, const int* offsets, const float* fracs, int stride, int num) noexcept
+        {
+            SIMD_KERNELS_LOOP
+            for (int j = 0; j < num; ++j)
+            {
+                auto* points = base + offsets[j];
+                out[j] = points[0] + (SampleType) fracs[j] * (points[-stride] - points[0]);
+            }
+        }
+
+        static void readLagrange3At(SampleType* out, const SampleType* base, const int* offsets, const float* fracs, int stride, int num) noexcept
+        {
+            SIMD_KERNELS_LOOP
+            for (int j = 0; j < num; ++j)
+            {
+                auto* points = base + offsets[j];
+                auto frac = (SampleType) fracs[j];
+                auto d1 = frac - (SampleType) 1.0;
+                auto d2 = frac - (SampleType) 2.0;
+                auto d3 = frac - (SampleType) 3.0;
+
+                auto c1 = d1 * d2 * d3 * (SampleType) (-1.0 / 6.0);
+                auto c2 = d2 * d3 * (SampleType) 0.5;
+                auto c3 = d1 * d3 * (SampleType) -0.5;
+                auto c4 = d1 * d2 * (SampleType) (1.0 / 6.0);
+
+                out[j] = points[0] * c1 + frac * (points[-stride] * c2 + points[-2 * stride] * c3 + points[-3 * stride] * c4);
+            }
+        }
+
+        static constexpr Table<SampleType> table { &add, &addWithGain, &addWithGains, &multiply, &multiplyByGains,
+                                                   &addFromLane, &copyToLane, &softClip, &crossfade, &svfLowPass, &svfLowPassLanes,
+                                                   &readLaneNearest, &readLaneLinear, &readLaneLagrange3,
+                                                   &readNearestAt, &readLinearAt, &readLagrange3At };
+    };
+
+    static const Tables tables { Kernels<float>::table, Kernels<double>::table };
+}
+}
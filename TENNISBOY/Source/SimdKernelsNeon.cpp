@@ -0,0 +1,33 @@
+/*
+  ==============================================================================
+
+    SimdKernelsNeon.cpp
+
+    NEON - the baseline on every ARM64 CPU, so no special compiler flags.
+
+  ==============================================================================
+*/
+
+#include "SimdKernels.h"
+
+#if defined (__aarch64__) || defined (_M_ARM64) || defined (__ARM_NEON)
+
+// SimdKernelsImpl.h sets GCC's optimisation options for the kernels - keep them to the kernels
+#if defined (__GNUC__) && ! defined (__clang__)
+ #pragma GCC push_options
+#endif
+
+#define SIMD_KERNELS_NAMESPACE Neon
+#include "SimdKernelsImpl.h"
+
+#if defined (__GNUC__) && ! defined (__clang__)
+ #pragma GCC pop_options
+#endif
+
+const SimdKernels::Tables* SimdKernels::Detail::getNeonTables() noexcept { return &Neon::tables; }
+
+#else
+
+const SimdKernels::Tables* SimdKernels::Detail::getNeonTables() noexcept { return nullptr; }
+
+#endif
@@ -0,0 +1,37 @@
+/*
+  ==============================================================================
+
+    SimdKernelsSSE2.cpp
+
+    SSE2 - the baseline on every x64 CPU, so no special compiler flags.
+
+  ==============================================================================
+*/
+
+#include "SimdKernels.h"
+
+#if defined (__x86_64__) || defined (_M_X64) || defined (__i386__) || defined (_M_IX86)
+
+#if defined (__clang__)
+ #pragma clang attribute push (__attribute__ ((target ("sse2"))), apply_to = function)
+#elif defined (__GNUC__)
+ #pragma GCC push_options
+ #pragma GCC target ("sse2")
+#endif
+
+#define SIMD_KERNELS_NAMESPACE SSE2
+#include "SimdKernelsImpl.h"
+
+#if defined (__clang__)
+ #pragma clang attribute pop
+#elif defined (__GNUC__)
+ #pragma GCC pop_options
+#endif
+
+const SimdKernels::Tables* SimdKernels::Detail::getSSE2Tables() noexcept { return &SSE2::tables; }
+
+#else
+
+const SimdKernels::Tables* SimdKernels::Detail::getSSE2Tables() noexcept { return nullptr; }
+
+#endif
@@ -0,0 +1,24 @@
+/*
+  ==============================================================================
+
+    SimdKernelsScalar.cpp
+
+    The scalar fallback - built everywhere, with vectorising turned off.
+
+  ==============================================================================
+*/
+
+// SimdKernelsImpl.h sets GCC's optimisation options for the kernels - keep them to the kernels
+#if defined (__GNUC__) && ! defined (__clang__)
+ #pragma GCC push_options
+#endif
+
+#define SIMD_KERNELS_NAMESPACE Scalar
+#define SIMD_KERNELS_VECTORISE 0
+#include "SimdKernelsImpl.h"
+
+#if defined (__GNUC__) && ! defined (__clang__)
+ #pragma GCC pop_options
+#endif
+
+const SimdKernels::Tables* SimdKernels::Detail::getScalarTables() noexcept { return &Scalar::tables; }
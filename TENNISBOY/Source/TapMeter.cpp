@@ -0,0 +1,67 @@
+/*
+  ==============================================================================
+
+    TapMeter.cpp
+
+  ==============================================================================
+*/
+
+#include "TapMeter.h"
+
+//==============================================================================
+void TapMeter::prepare(double sampleRate) noexcept
+{
+    windowLength = juce::jmax(1, juce::roundToInt(sampleRate / framesPerSecond));
+    windowPosition = 0;
+    sumLeft = sumRight = 0.0f;
+}
+
+template <typename SampleType>
+void TapMeter::push(const SampleType* left, const SampleType* right, int numSamples) noexcept
+{
+    for (int start = 0; start < numSamples;)
+    {
+        auto numToAdd = juce::jmin(numSamples - start, windowLength - windowPosition);
+
+        for (int i = start; i < start + numToAdd; ++i)
+        {
+            sumLeft += (float) (left[i] * left[i]);
+            sumRight += (float) (right[i] * right[i]);
+        }
+
+        start += numToAdd;
+        windowPosition += numToAdd;
+
+        if (windowPosition < windowLength)
+            break;
+
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite(1, start1, size1, start2, size2);
+
+        if (size1 + size2 > 0) // Full means the editor's closed - just lose the frame
+        {
+            auto scale = 1.0f / (float) windowLength;
+            fifoData[(size_t) (size1 > 0 ? start1 : start2)] = { std::sqrt(sumLeft * scale), std::sqrt(sumRight * scale) };
+            fifo.finishedWrite(1);
+        }
+
+        windowPosition = 0;
+        sumLeft = sumRight = 0.0f;
+    }
+}
+
+template void TapMeter::push(const float*, const float*, int) noexcept;
+template void TapMeter::push(const double*, const double*, int) noexcept;
+
+//==============================================================================
+int TapMeter::pull(Frame* dest, int maxFrames) noexcept
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToRead(juce::jmin(maxFrames, fifo.getNumReady()), start1, size1, start2, size2);
+
+    std::copy_n(fifoData.begin() + start1, size1, dest);
+    std::copy_n(fifoData.begin() + start2, size2, dest + size1);
+
+    fifo.finishedRead(size1 + size2);
+    return size1 + size2;
+}
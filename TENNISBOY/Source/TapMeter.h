@@ -0,0 +1,61 @@
+/*
+  ==============================================================================
+
+    TapMeter.h
+
+    Decimated L/R delay tap levels for the editor's visualiser. The audio
+    thread folds each block of wet output into running sums and pushes one
+    RMS pair per window (about 60 a second) into a wait-free single
+    producer/single consumer FIFO, which the editor drains on a timer.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Audio thread: push() only - no locks, no allocation.
+    Message thread: pull().
+*/
+class TapMeter
+{
+public:
+    /** RMS of each tap over one window. */
+    struct Frame
+    {
+        float left = 0.0f, right = 0.0f;
+    };
+
+    TapMeter() = default;
+
+    //==============================================================================
+    /** Sets the window length for the session rate. Leaves the FIFO alone, so it's safe while the editor is reading. */
+    void prepare(double sampleRate) noexcept;
+
+    /** Adds a block of tap output (float or double). Wait-free - audio thread only. */
+    template <typename SampleType>
+    void push(const SampleType* left, const SampleType* right, int numSamples) noexcept;
+
+    //==============================================================================
+    /** Copies up to maxFrames of the oldest waiting frames into dest and returns how many there were. Message thread only. */
+    int pull(Frame* dest, int maxFrames) noexcept;
+
+    /** Window rate - the editor needs no more than this to follow the meter. */
+    static constexpr double framesPerSecond = 60.0;
+
+private:
+    //==============================================================================
+    static constexpr int fifoSize = 128; // Two seconds' worth - if nobody reads, frames are just dropped
+
+    juce::AbstractFifo fifo { fifoSize };
+    std::array<Frame, fifoSize> fifoData;
+
+    // Producer side - only touched on the audio thread
+    int windowLength = 735, windowPosition = 0;
+    float sumLeft = 0.0f, sumRight = 0.0f;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TapMeter)
+};
@@ -0,0 +1,73 @@
+/*
+  ==============================================================================
+
+    TapVisualiser.cpp
+
+  ==============================================================================
+*/
+
+#include "TapVisualiser.h"
+
+//==============================================================================
+TapVisualiser::TapVisualiser(TapMeter& meterToShow)
+    : meter(meterToShow)
+{
+    setOpaque(true); // Fills its whole area, so the editor behind never needs repainting for it
+    startTimerHz(30);
+}
+
+TapVisualiser::~TapVisualiser()
+{
+    stopTimer();
+}
+
+//==============================================================================
+void TapVisualiser::timerCallback()
+{
+    auto numNew = meter.pull(incoming.data(), historySize);
+
+    if (numNew == 0)
+        return; // Nothing new (transport stopped) - no repaint at all
+
+    for (int i = 0; i < numNew; ++i)
+    {
+        history[(size_t) historyStart] = incoming[(size_t) i];
+        historyStart = (historyStart + 1) % historySize;
+    }
+
+    repaint();
+}
+
+void TapVisualiser::paint(juce::Graphics& g)
+{
+    g.fillAll(juce::Colours::black);
+
+    auto bounds = getLocalBounds().toFloat().reduced(1.0f);
+    auto halfHeight = bounds.getHeight() * 0.5f;
+    auto centre = bounds.getCentreY();
+    auto columnWidth = bounds.getWidth() / (float) historySize;
+
+    //-60dB to 0dB mapped onto each half - L grows up from the centre line, R down
+    auto toHeight = [halfHeight] (float rms)
+    {
+        auto db = juce::Decibels::gainToDecibels(rms, -60.0f);
+        return juce::jmap(db, -60.0f, 0.0f, 0.0f, halfHeight);
+    };
+
+    for (int i = 0; i < historySize; ++i)
+    {
+        auto& frame = history[(size_t) ((historyStart + i) % historySize)]; // Oldest on the left
+        auto x = bounds.getX() + (float) i * columnWidth;
+
+        auto leftHeight = toHeight(frame.left);
+        auto rightHeight = toHeight(frame.right);
+
+        g.setColour(juce::Colours::orange);
+        g.fillRect(x, centre - leftHeight, columnWidth, leftHeight);
+        g.setColour(juce::Colours::skyblue);
+        g.fillRect(x, centre, columnWidth, rightHeight);
+    }
+
+    g.setColour(juce::Colours::grey);
+    g.drawHorizontalLine(juce::roundToInt(centre), bounds.getX(), bounds.getRight());
+}
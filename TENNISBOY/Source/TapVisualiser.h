@@ -0,0 +1,43 @@
+/*
+  ==============================================================================
+
+    TapVisualiser.h
+
+    Scrolling display of the L/R delay tap levels, drawn from a TapMeter.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "TapMeter.h"
+
+//==============================================================================
+/**
+    Opaque, and only repaints itself - and only when new frames have arrived -
+    so the meter never makes the rest of the editor redraw.
+*/
+class TapVisualiser : public juce::Component,
+    private juce::Timer
+{
+public:
+    explicit TapVisualiser(TapMeter& meterToShow);
+    ~TapVisualiser() override;
+
+    void paint(juce::Graphics&) override;
+
+private:
+    void timerCallback() override;
+
+    //==============================================================================
+    static constexpr int historySize = 64; // Columns across the display
+
+    TapMeter& meter;
+
+    std::array<TapMeter::Frame, historySize> history; // Circular, newest at historyStart - 1
+    int historyStart = 0;
+    std::array<TapMeter::Frame, historySize> incoming;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TapVisualiser)
+};
@@ -0,0 +1,83 @@
+/*
+  ==============================================================================
+
+    TempoSync.h
+
+    Delay times locked to the host's tempo, and how the delay moves when the
+    time changes. The note divisions are lengths in beats (quarter notes),
+    turned into milliseconds with whatever tempo the host's play head last
+    reported.
+
+    A change of delay time either glides, sweeping the read heads (and the
+    pitch of the repeats) over to the new time, or crossfades - a second head
+    starts at the new time and the two are faded over a few milliseconds (see
+    PingPongKernel::startCrossfade), one fade after another while the time
+    keeps moving. Crossfaded, the delay never has to sit
+    between two samples, so with no wow or flutter the taps are read at whole
+    samples with no interpolation at all.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+namespace TempoSync
+{
+    /** Tempo used until the host reports one - and by hosts that never do. */
+    constexpr double defaultBpm = 120.0;
+
+    /** How long a crossfaded delay time change takes. */
+    constexpr double crossfadeSeconds = 0.02;
+
+    /** How the delay time moves to a new value. */
+    enum class Transition
+    {
+        glide = 0,  // The read heads sweep to the new time - the original sound
+        crossfade   // A second head at the new time, crossfaded in over crossfadeSeconds
+    };
+
+    inline juce::StringArray getTransitionNames() { return { "Glide", "Crossfade" }; }
+
+    //==============================================================================
+    /** A note division - its name, and its length in beats. */
+    struct Division
+    {
+        const char* name;
+        double beats;
+    };
+
+    inline const std::array<Division, 14>& getDivisions() noexcept
+    {
+        static const std::array<Division, 14> divisions {{ { "1/1", 4.0 },
+                                                           { "1/2", 2.0 },   { "1/2 dotted", 3.0 },     { "1/2 triplet", 4.0 / 3.0 },
+                                                           { "1/4", 1.0 },   { "1/4 dotted", 1.5 },     { "1/4 triplet", 2.0 / 3.0 },
+                                                           { "1/8", 0.5 },   { "1/8 dotted", 0.75 },    { "1/8 triplet", 1.0 / 3.0 },
+                                                           { "1/16", 0.25 }, { "1/16 dotted", 0.375 },  { "1/16 triplet", 1.0 / 6.0 },
+                                                           { "1/32", 0.125 } }};
+        return divisions;
+    }
+
+    /** The division the parameter starts on - 1/4. */
+    constexpr int defaultDivision = 4;
+
+    inline juce::StringArray getDivisionNames()
+    {
+        juce::StringArray names;
+
+        for (auto& division : getDivisions())
+            names.add(division.name);
+
+        return names;
+    }
+
+    /** Length of a division (out of range gives the default) in milliseconds at a tempo. */
+    inline float getDelayMs(int division, double bpm) noexcept
+    {
+        auto& divisions = getDivisions();
+        auto beats = divisions[(size_t) (division >= 0 && division < (int) divisions.size() ? division : defaultDivision)].beats;
+        return (float) (beats * 60000.0 / juce::jmax(1.0, bpm));
+    }
+}
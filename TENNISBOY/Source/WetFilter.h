@@ -0,0 +1,159 @@
+/*
+  ==============================================================================
+
+    WetFilter.h
+
+    Resonant low pass filter for the wet path. Topology-preserving-transform
+    (TPT) state variable design, so the cutoff and Q can be changed every
+    sample without the filter blowing up and without allocating coefficient
+    objects on the audio thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SimdKernels.h"
+
+//==============================================================================
+/**
+    Per-channel TPT state variable low pass.
+
+    The response is the same as the RBJ biquad made by
+    IIR::Coefficients::makeLowPass (bilinear transform prewarped at the cutoff),
+    but the coefficients are three plain numbers. They are only recalculated when
+    the cutoff or Q targets actually move, and while a target is ramping they are
+    recalculated per sample so sweeps are smooth. The settled loop is
+    SimdKernels::Table::svfLowPass, in whichever instruction set the delay
+    kernel is running.
+
+    SampleType is float or double - the coefficients and state follow it, the
+    parameter smoothers stay float.
+*/
+template <typename SampleType>
+class WetFilter
+{
+public:
+    WetFilter() = default;
+
+    //==============================================================================
+    /** Sizes the per-channel state and picks up the real sample rate. Not realtime safe. */
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        sampleRate = spec.sampleRate;
+        s1.assign((size_t) spec.numChannels, SampleType());
+        s2.assign((size_t) spec.numChannels, SampleType());
+
+        cutoff.reset(sampleRate, rampLengthSeconds);
+        resonance.reset(sampleRate, rampLengthSeconds);
+
+        updateCoefficients(cutoff.getTargetValue(), resonance.getTargetValue());
+    }
+
+    /** Clears the filter state, and jumps the smoothers to their targets. */
+    void reset()
+    {
+        std::fill(s1.begin(), s1.end(), SampleType());
+        std::fill(s2.begin(), s2.end(), SampleType());
+
+        cutoff.setCurrentAndTargetValue(cutoff.getTargetValue());
+        resonance.setCurrentAndTargetValue(resonance.getTargetValue());
+        updateCoefficients(cutoff.getTargetValue(), resonance.getTargetValue());
+    }
+
+    /** Moves the filter to another sample rate - for running it oversampled. Keeps its state, jumps the smoothers and allocates nothing. */
+    void setSampleRate(double newSampleRate) noexcept
+    {
+        sampleRate = newSampleRate;
+
+        cutoff.reset(sampleRate, rampLengthSeconds);
+        resonance.reset(sampleRate, rampLengthSeconds);
+
+        updateCoefficients(cutoff.getTargetValue(), resonance.getTargetValue());
+    }
+
+    //==============================================================================
+    /** Sets the target cutoff in Hz. Cheap to call every block - nothing happens if the value hasn't changed. */
+    void setCutoffFrequency(float newCutoffHz) noexcept
+    {
+        if (newCutoffHz != cutoff.getTargetValue())
+            cutoff.setTargetValue(newCutoffHz);
+    }
+
+    /** Sets the target resonance (Q). Cheap to call every block - nothing happens if the value hasn't changed. */
+    void setResonance(float newQ) noexcept
+    {
+        if (newQ != resonance.getTargetValue())
+            resonance.setTargetValue(newQ);
+    }
+
+    /** The settled loop, for one instruction set - the processor passes on the delay kernel's. Realtime safe. */
+    void setKernels(const SimdKernels::Table<SampleType>& newKernels) noexcept { kernels = &newKernels; }
+
+    //==============================================================================
+    /** Filters every channel of the block in place. */
+    void process(const juce::dsp::AudioBlock<SampleType>& block) noexcept
+    {
+        auto numChannels = juce::jmin((int) block.getNumChannels(), (int) s1.size());
+        auto numSamples = (int) block.getNumSamples();
+
+        if (! cutoff.isSmoothing() && ! resonance.isSmoothing())
+        {
+            // Settled: coefficients are constant for the whole block
+            for (int channel = 0; channel < numChannels; ++channel)
+                kernels->svfLowPass(block.getChannelPointer((size_t) channel), numSamples, g, k1, h, &s1[(size_t) channel], &s2[(size_t) channel]);
+
+            return;
+        }
+
+        // Ramping: step the smoothers once per sample frame and keep every channel on the same coefficients
+        for (int i = 0; i < numSamples; ++i)
+        {
+            updateCoefficients(cutoff.getNextValue(), resonance.getNextValue());
+
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                auto* data = block.getChannelPointer((size_t) channel);
+                data[i] = tick(data[i], s1[(size_t) channel], s2[(size_t) channel]);
+            }
+        }
+    }
+
+private:
+    //==============================================================================
+    SampleType tick(SampleType in, SampleType& z1, SampleType& z2) const noexcept
+    {
+        auto hp = (in - k1 * z1 - z2) * h;
+        auto bp = g * hp + z1;
+        z1 = g * hp + bp;
+        auto lp = g * bp + z2;
+        z2 = g * bp + lp;
+        return lp;
+    }
+
+    void updateCoefficients(float cutoffHz, float q) noexcept
+    {
+        auto nyquistSafe = (SampleType) (sampleRate * 0.49);
+        auto fc = juce::jlimit((SampleType) 1, nyquistSafe, (SampleType) cutoffHz);
+
+        g = std::tan(juce::MathConstants<SampleType>::pi * fc / (SampleType) sampleRate);
+        auto k = (SampleType) 1 / (SampleType) juce::jmax(q, 0.01f);
+        k1 = k + g;
+        h = (SampleType) 1 / ((SampleType) 1 + g * k1);
+    }
+
+    //==============================================================================
+    static constexpr double rampLengthSeconds = 0.02;
+
+    double sampleRate = 44100.0;
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> cutoff { 600.0f };
+    juce::SmoothedValue<float> resonance { 1.0f };
+
+    SampleType g = 0, k1 = 0, h = 0;     // Prewarped gain, (1/Q + g) and the 1 / (1 + g(1/Q + g)) normaliser
+    std::vector<SampleType> s1, s2;      // Integrator states, one per channel
+
+    const SimdKernels::Table<SampleType>* kernels = &SimdKernels::getTable<SampleType>(SimdKernels::Isa::scalar);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WetFilter)
+};
@@ -0,0 +1,158 @@
+/*
+  ==============================================================================
+
+    WowFlutter.h
+
+    Tape-style pitch wobble for the delay taps: a slow "wow" LFO and a fast
+    "flutter" LFO, both read from one shared sine wavetable, turned into
+    per-sample delay time offsets for every lane of the delay bank.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Wow and flutter delay offsets for every lane of an interleaved span of frames.
+
+    The offsets are in samples and never negative - at full depth the delay
+    swings between its own length and maxDepthMs longer - so modulated taps
+    never read closer to the write head than unmodulated ones would. Each lane
+    runs a quarter cycle on from the one before, so the repeats drift apart
+    across the stereo field instead of wobbling together.
+
+    Both LFOs are read from a small linearly interpolated wavetable, so a
+    frame costs a couple of table reads per lane rather than any calls to sin.
+    Depth changes glide over 50ms.
+*/
+class WowFlutter
+{
+public:
+    /** Most lanes a WowFlutter can run - the same as PingPongKernel. */
+    static constexpr int maxLanes = 16;
+
+    static constexpr float wowRateHz = 0.6f, flutterRateHz = 6.5f;
+    static constexpr float maxWowMs = 2.0f, maxFlutterMs = 0.25f;
+
+    /** Furthest the offsets can push a tap past its unmodulated delay - allow for it when sizing the delay lines. */
+    static constexpr float maxDepthMs = maxWowMs + maxFlutterMs;
+
+    /** Points in one cycle of the sine wavetable. */
+    static constexpr int tableSize = 1024;
+
+    WowFlutter() = default;
+
+    //==============================================================================
+    /** Picks up the sample rate and the number of interleaved lanes. Allocates nothing. */
+    void prepare(double newSampleRate, int numLanesToUse) noexcept
+    {
+        sampleRate = newSampleRate;
+        numLanes = juce::jlimit(1, maxLanes, numLanesToUse);
+
+        wowIncrement = (float) (wowRateHz / sampleRate);
+        flutterIncrement = (float) (flutterRateHz / sampleRate);
+
+        for (int lane = 0; lane < numLanes; ++lane)
+            lanePhases[(size_t) lane] = (float) (lane % 4) * 0.25f;
+
+        wowDepth.reset(sampleRate, depthRampSeconds);
+        flutterDepth.reset(sampleRate, depthRampSeconds);
+        getSineTable(); // Builds the shared table here, rather than on the audio thread
+        reset();
+    }
+
+    /** Restarts both LFOs at the top of their cycles and jumps the depths to their targets. */
+    void reset() noexcept
+    {
+        wowPhase = flutterPhase = 0.0f;
+        wowDepth.setCurrentAndTargetValue(wowDepth.getTargetValue());
+        flutterDepth.setCurrentAndTargetValue(flutterDepth.getTargetValue());
+    }
+
+    /** Sets the wow and flutter amounts, 0 to 1 of their full depths. Cheap to call every block. */
+    void setDepths(float wowAmount, float flutterAmount) noexcept
+    {
+        // Held as half the peak to peak swing, as the offset is depth * (1 + sine)
+        wowDepth.setTargetValue(juce::jlimit(0.0f, 1.0f, wowAmount) * toHalfSwing(maxWowMs));
+        flutterDepth.setTargetValue(juce::jlimit(0.0f, 1.0f, flutterAmount) * toHalfSwing(maxFlutterMs));
+    }
+
+    /** False once both depths have settled at zero - there's nothing to add, so the caller can take its unmodulated path. */
+    bool isActive() const noexcept
+    {
+        return wowDepth.getCurrentValue() > 0.0f || flutterDepth.getCurrentValue() > 0.0f
+            || wowDepth.isSmoothing() || flutterDepth.isSmoothing();
+    }
+
+    //==============================================================================
+    /** Writes numFrames interleaved frames of numLanes offsets (in samples) and moves both LFOs on. */
+    void fill(float* offsets, int numFrames) noexcept
+    {
+        for (int frame = 0; frame < numFrames; ++frame)
+        {
+            auto wow = wowDepth.getNextValue();
+            auto flutter = flutterDepth.getNextValue();
+            auto* out = offsets + frame * numLanes;
+
+            for (int lane = 0; lane < numLanes; ++lane)
+            {
+                auto lanePhase = lanePhases[(size_t) lane];
+                out[lane] = wow * (1.0f + sine(wowPhase + lanePhase)) + flutter * (1.0f + sine(flutterPhase + lanePhase));
+            }
+
+            wowPhase = wrap(wowPhase + wowIncrement);
+            flutterPhase = wrap(flutterPhase + flutterIncrement);
+        }
+    }
+
+    //==============================================================================
+    /** sin(2 pi phase) from the wavetable, for a phase of 0 up to (but not including) 2 cycles. */
+    static float sine(float phase) noexcept
+    {
+        auto& table = getSineTable();
+        auto position = wrap(phase) * (float) tableSize;
+        auto index = (int) position;
+        auto frac = position - (float) index;
+
+        return table[(size_t) index] + frac * (table[(size_t) index + 1] - table[(size_t) index]);
+    }
+
+private:
+    //==============================================================================
+    static float wrap(float phase) noexcept { return phase >= 1.0f ? phase - 1.0f : phase; }
+
+    float toHalfSwing(float milliseconds) const noexcept { return (float) (milliseconds * sampleRate / 2000.0); }
+
+    /** One cycle of sine, with the first point repeated at the end so a read never has to wrap. Shared by every instance. */
+    static const std::array<float, tableSize + 1>& getSineTable() noexcept
+    {
+        static const auto table = []
+        {
+            std::array<float, tableSize + 1> points;
+
+            for (int i = 0; i <= tableSize; ++i)
+                points[(size_t) i] = (float) std::sin(juce::MathConstants<double>::twoPi * (i % tableSize) / tableSize);
+
+            return points;
+        }();
+
+        return table;
+    }
+
+    //==============================================================================
+    static constexpr double depthRampSeconds = 0.05;
+
+    double sampleRate = 44100.0;
+    int numLanes = 2;
+
+    float wowPhase = 0.0f, flutterPhase = 0.0f;         // Cycles, 0 to 1
+    float wowIncrement = 0.0f, flutterIncrement = 0.0f; // Cycles per frame
+    std::array<float, maxLanes> lanePhases {};          // Each lane's offset into both cycles
+
+    juce::SmoothedValue<float> wowDepth { 0.0f }, flutterDepth { 0.0f }; // Samples - half the peak to peak swing
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WowFlutter)
+};
@@ -0,0 +1,515 @@
+/*
+  ==============================================================================
+
+    Benchmarks.cpp
+
+  ==============================================================================
+*/
+
+#include "Benchmarks.h"
+#include "../../Source/PluginProcessor.h"
+#include "ReferenceDelay.h"
+#include "TestSignals.h"
+
+#if JUCE_LINUX
+ #include <fstream>
+ #include <unistd.h>
+#endif
+
+namespace Benchmarks
+{
+    namespace
+    {
+        constexpr int numChannels = 2;
+
+        /** Calls processOneBlock until secondsOfAudio have gone through, and returns the time taken per sample frame in ns.
+            Every block starts with a copy of fresh noise into the buffer, which is included in the time.
+        */
+        template <typename ProcessOneBlock>
+        double measure(int blockSize, double sampleRate, double secondsOfAudio, ProcessOneBlock&& processOneBlock)
+        {
+            auto numBlocks = juce::jmax(16, (int) (secondsOfAudio * sampleRate / blockSize));
+
+            for (int i = 0; i < 16; ++i) // Warm up - caches, branch predictors, and the first pass over the delay memory
+                processOneBlock();
+
+            auto start = juce::Time::getHighResolutionTicks();
+
+            for (int i = 0; i < numBlocks; ++i)
+                processOneBlock();
+
+            auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+            return seconds * 1.0e9 / ((double) numBlocks * (double) blockSize);
+        }
+
+        /** One second of noise, copied into the block each time round so the feedback loop never runs dry. */
+        struct NoiseSource
+        {
+            NoiseSource(double sampleRate)
+                : noise(numChannels, (int) sampleRate)
+            {
+                juce::Random random(0x7ab1e);
+                TestSignals::fillWithNoise(noise, random);
+            }
+
+            void fill(juce::AudioBuffer<float>& block)
+            {
+                if (position + block.getNumSamples() > noise.getNumSamples())
+                    position = 0;
+
+                for (int channel = 0; channel < numChannels; ++channel)
+                    block.copyFrom(channel, 0, noise, channel, position, block.getNumSamples());
+
+                position += block.getNumSamples();
+            }
+
+            juce::AudioBuffer<float> noise;
+            int position = 0;
+        };
+
+        juce::String column(const juce::String& text, int width) { return text.paddedLeft(' ', width); }
+        juce::String column(double value, int width)               { return column(juce::String(value, 2), width); }
+
+        //==============================================================================
+        /** The wet filter at the base rate, or run 2x/4x oversampled the way the processor does it (factorLog2 1 or 2). */
+        double benchmarkFilter(int blockSize, double sampleRate, double seconds, int factorLog2 = 0,
+                               SimdKernels::Isa isa = SimdKernels::getPreferredIsa())
+        {
+            WetFilter<float> filter;
+            filter.setKernels(SimdKernels::getTable<float>(isa));
+            filter.setCutoffFrequency(600.0f);
+            filter.prepare({ sampleRate, (juce::uint32) blockSize, (juce::uint32) numChannels });
+            filter.setSampleRate(sampleRate * (double) (1 << factorLog2));
+            filter.reset();
+
+            juce::dsp::Oversampling<float> oversampler((size_t) numChannels, (size_t) juce::jmax(1, factorLog2), juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR);
+            oversampler.initProcessing((size_t) blockSize);
+
+            NoiseSource source(sampleRate);
+            juce::AudioBuffer<float> block(numChannels, blockSize);
+
+            return measure(blockSize, sampleRate, seconds, [&]
+            {
+                source.fill(block);
+                juce::dsp::AudioBlock<float> audio(block);
+
+                if (factorLog2 > 0)
+                {
+                    filter.process(oversampler.processSamplesUp(audio));
+                    oversampler.processSamplesDown(audio);
+                }
+                else
+                {
+                    filter.process(audio);
+                }
+            });
+        }
+
+        double benchmarkDelay(int blockSize, double sampleRate, float delayMs, double seconds, bool wowAndFlutter = false,
+                              SimdKernels::Isa isa = SimdKernels::getPreferredIsa())
+        {
+            PingPongKernel<float> kernel;
+            kernel.prepare(numChannels, (int) std::ceil((3000.0 + WowFlutter::maxDepthMs) * sampleRate / 1000.0));
+            kernel.setTapTable(TapPatterns::get(0));
+            kernel.setIsa(isa);
+
+            if (wowAndFlutter)
+            {
+                kernel.getModulation().prepare(sampleRate, numChannels);
+                kernel.getModulation().setDepths(0.5f, 0.5f);
+                kernel.getModulation().reset();
+            }
+
+            auto delay = (float) (delayMs * sampleRate / 1000.0);
+            NoiseSource source(sampleRate);
+            juce::AudioBuffer<float> block(numChannels, blockSize);
+
+            return measure(blockSize, sampleRate, seconds, [&]
+            {
+                source.fill(block);
+                kernel.process<DelayInterpolation::Linear>(block.getArrayOfWritePointers(), blockSize, delay, 0.5f, 0.5f, false);
+            });
+        }
+
+        /** The paged long delay on its own. Also returns the delay memory it allocated, which should follow the delay time. */
+        double benchmarkLongDelay(int blockSize, double sampleRate, double delaySeconds, double seconds, size_t& allocatedBytes)
+        {
+            PagedDelay<float> delayLine;
+            delayLine.prepare(numChannels, (int) std::ceil(60.0 * sampleRate), juce::roundToInt(delaySeconds * sampleRate));
+
+            NoiseSource source(sampleRate);
+            juce::AudioBuffer<float> block(numChannels, blockSize);
+
+            auto result = measure(blockSize, sampleRate, seconds, [&]
+            {
+                source.fill(block);
+                delayLine.process(block.getArrayOfWritePointers(), blockSize, 0.5f, 0.5f, false, false);
+            });
+
+            allocatedBytes = delayLine.getAllocatedBytes();
+            return result;
+        }
+
+        double benchmarkProcessBlock(int blockSize, double sampleRate, float delayMs, double seconds, bool loopFilter = false)
+        {
+            TableTennisAudioProcessor processor;
+            processor.setPlayConfigDetails(numChannels, numChannels, sampleRate, blockSize);
+
+            ParameterSnapshot parameters;
+            parameters.delayTimeMs = delayMs;
+            parameters.loopFilter = loopFilter;
+            TestSignals::applyParameters(processor, parameters);
+            processor.prepareToPlay(sampleRate, blockSize);
+
+            NoiseSource source(sampleRate);
+            juce::AudioBuffer<float> block(numChannels, blockSize);
+            juce::MidiBuffer midi;
+
+            auto result = measure(blockSize, sampleRate, seconds, [&]
+            {
+                source.fill(block);
+                processor.processBlock(block, midi);
+            });
+
+            processor.releaseResources();
+            return result;
+        }
+
+        /** processBlock with the cutoff swept up and down a little every block, as host automation would, at one automation granularity. */
+        double benchmarkAutomation(int granularity, int blockSize, double sampleRate, double seconds)
+        {
+            TableTennisAudioProcessor processor;
+            processor.setPlayConfigDetails(numChannels, numChannels, sampleRate, blockSize);
+            processor.setAutomationGranularity(granularity);
+
+            ParameterSnapshot parameters;
+            parameters.delayTimeMs = 375.0f;
+            TestSignals::applyParameters(processor, parameters);
+            processor.prepareToPlay(sampleRate, blockSize);
+
+            juce::AudioProcessorParameter* cutoff = nullptr;
+
+            for (auto* param : processor.getParameters())
+                if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(param))
+                    if (ranged->paramID == "lpf")
+                        cutoff = ranged;
+
+            NoiseSource source(sampleRate);
+            juce::AudioBuffer<float> block(numChannels, blockSize);
+            juce::MidiBuffer midi;
+            int blockNumber = 0;
+
+            auto result = measure(blockSize, sampleRate, seconds, [&]
+            {
+                cutoff->setValueNotifyingHost((float) (blockNumber++ % 32) / 32.0f);
+                source.fill(block);
+                processor.processBlock(block, midi);
+            });
+
+            processor.releaseResources();
+            return result;
+        }
+
+        double benchmarkReference(int blockSize, double sampleRate, float delayMs, double seconds)
+        {
+            ParameterSnapshot parameters;
+            parameters.delayTimeMs = delayMs;
+
+            Reference::Processor<float> reference;
+            reference.prepare(sampleRate, numChannels);
+            reference.setParameters(parameters);
+
+            NoiseSource source(sampleRate);
+            juce::AudioBuffer<float> block(numChannels, blockSize);
+
+            return measure(blockSize, sampleRate, seconds, [&]
+            {
+                source.fill(block);
+                reference.process(block);
+            });
+        }
+
+        //==============================================================================
+        /** The process's resident memory, from /proc - 0 where that isn't available. */
+        size_t getResidentBytes()
+        {
+           #if JUCE_LINUX
+            std::ifstream statm("/proc/self/statm");
+            size_t totalPages = 0, residentPages = 0;
+
+            if (statm >> totalPages >> residentPages)
+                return residentPages * (size_t) sysconf(_SC_PAGESIZE);
+           #endif
+
+            return 0;
+        }
+
+        /** One of the host's audio threads. Each callback it gives every one of its instances a block of fresh noise to process,
+            and times the whole callback, the way a host's engine would see it.
+        */
+        class StressWorker  : public juce::Thread
+        {
+        public:
+            StressWorker(juce::Array<TableTennisAudioProcessor*> instancesToRun, double sampleRate, int blockSize, int numCallbacksToRun)
+                : juce::Thread("Stress worker"), instances(std::move(instancesToRun)), numCallbacks(numCallbacksToRun),
+                  source(sampleRate), block(numChannels, blockSize)
+            {
+            }
+
+            void run() override
+            {
+                juce::MidiBuffer midi;
+
+                for (int callback = 0; callback < numCallbacks && ! threadShouldExit(); ++callback)
+                {
+                    auto start = juce::Time::getHighResolutionTicks();
+
+                    for (auto* instance : instances)
+                    {
+                        source.fill(block);
+                        instance->processBlock(block, midi);
+                    }
+
+                    auto ticks = juce::Time::getHighResolutionTicks() - start;
+                    busyTicks += ticks;
+                    worstCallbackTicks = juce::jmax(worstCallbackTicks, ticks);
+                }
+            }
+
+            juce::int64 busyTicks = 0, worstCallbackTicks = 0; // Read once the thread has finished
+
+        private:
+            juce::Array<TableTennisAudioProcessor*> instances;
+            int numCallbacks;
+            NoiseSource source;
+            juce::AudioBuffer<float> block;
+        };
+    }
+
+    //==============================================================================
+    void run(const Settings& settings)
+    {
+        juce::ScopedNoDenormals noDenormals; // processBlock sets this itself - the filter and kernel on their own don't
+
+        std::cout << "ns per stereo sample frame, " << settings.secondsPerCase << " s of audio per case, "
+                  << SimdKernels::getName(SimdKernels::getPreferredIsa()) << " kernels" << std::endl << std::endl;
+
+        std::cout << "Wet filter, at the base rate and oversampled" << std::endl
+                  << column("rate", 8) << column("block", 7) << column("1x", 10) << column("2x", 10) << column("4x", 10) << std::endl;
+
+        for (auto sampleRate : settings.sampleRates)
+            for (auto blockSize : settings.blockSizes)
+                std::cout << column(juce::String(sampleRate, 0), 8) << column(juce::String(blockSize), 7)
+                          << column(benchmarkFilter(blockSize, sampleRate, settings.secondsPerCase), 10)
+                          << column(benchmarkFilter(blockSize, sampleRate, settings.secondsPerCase, 1), 10)
+                          << column(benchmarkFilter(blockSize, sampleRate, settings.secondsPerCase, 2), 10) << std::endl;
+
+        std::cout << std::endl << "Delay kernel (Classic, linear), without and with wow and flutter, and full processBlock with the LPF on the input and in the feedback loop" << std::endl
+                  << column("rate", 8) << column("block", 7) << column("delay ms", 10) << column("kernel", 10) << column("wobble", 10)
+                  << column("process", 10) << column("in loop", 10) << column("cost", 7)
+                  << (settings.includeReference ? column("reference", 11) + column("speedup", 9) : juce::String())
+                  << std::endl;
+
+        for (auto sampleRate : settings.sampleRates)
+        {
+            for (auto blockSize : settings.blockSizes)
+            {
+                for (auto delayMs : settings.delayTimesMs)
+                {
+                    auto kernel = benchmarkDelay(blockSize, sampleRate, delayMs, settings.secondsPerCase);
+                    auto wobble = benchmarkDelay(blockSize, sampleRate, delayMs, settings.secondsPerCase, true);
+                    auto process = benchmarkProcessBlock(blockSize, sampleRate, delayMs, settings.secondsPerCase);
+                    auto inLoop = benchmarkProcessBlock(blockSize, sampleRate, delayMs, settings.secondsPerCase, true);
+
+                    std::cout << column(juce::String(sampleRate, 0), 8) << column(juce::String(blockSize), 7)
+                              << column(juce::String(delayMs, 0), 10) << column(kernel, 10) << column(wobble, 10) << column(process, 10)
+                              << column(inLoop, 10) << column(juce::String(inLoop / process, 2) + "x", 7);
+
+                    if (settings.includeReference)
+                    {
+                        auto reference = benchmarkReference(blockSize, sampleRate, delayMs, settings.secondsPerCase);
+                        std::cout << column(reference, 11) << column(juce::String(reference / process, 1) + "x", 9);
+                    }
+
+                    std::cout << std::endl;
+                }
+            }
+        }
+
+        std::cout << std::endl << "Delay kernel (Classic, linear, 375 ms) with each instruction set's build of SimdKernels this CPU can run" << std::endl
+                  << column("rate", 8) << column("block", 7);
+
+        juce::Array<SimdKernels::Isa> isas;
+
+        for (int i = 0; i < (int) SimdKernels::Isa::numIsas; ++i)
+        {
+            if (SimdKernels::isSupported((SimdKernels::Isa) i))
+            {
+                isas.add((SimdKernels::Isa) i);
+                std::cout << column(SimdKernels::getName((SimdKernels::Isa) i), 10);
+            }
+        }
+
+        std::cout << std::endl;
+
+        for (auto sampleRate : settings.sampleRates)
+        {
+            for (auto blockSize : settings.blockSizes)
+            {
+                std::cout << column(juce::String(sampleRate, 0), 8) << column(juce::String(blockSize), 7);
+
+                for (auto isa : isas)
+                    std::cout << column(benchmarkDelay(blockSize, sampleRate, 375.0f, settings.secondsPerCase, false, isa), 10);
+
+                std::cout << std::endl;
+            }
+        }
+
+        std::cout << std::endl << "Wet filter (settled) with each instruction set's build" << std::endl
+                  << column("rate", 8) << column("block", 7);
+
+        for (auto isa : isas)
+            std::cout << column(SimdKernels::getName(isa), 10);
+
+        std::cout << std::endl;
+
+        for (auto sampleRate : settings.sampleRates)
+        {
+            for (auto blockSize : settings.blockSizes)
+            {
+                std::cout << column(juce::String(sampleRate, 0), 8) << column(juce::String(blockSize), 7);
+
+                for (auto isa : isas)
+                    std::cout << column(benchmarkFilter(blockSize, sampleRate, settings.secondsPerCase, 0, isa), 10);
+
+                std::cout << std::endl;
+            }
+        }
+
+        std::cout << std::endl << "Long delay on its own, and the memory it allocated" << std::endl
+                  << column("rate", 8) << column("block", 7) << column("delay s", 9) << column("ns", 10) << column("MB", 9) << std::endl;
+
+        for (auto sampleRate : settings.sampleRates)
+        {
+            for (auto blockSize : settings.blockSizes)
+            {
+                for (auto delaySeconds : { 1.0, 10.0, 60.0 })
+                {
+                    size_t allocatedBytes = 0;
+                    auto longDelay = benchmarkLongDelay(blockSize, sampleRate, delaySeconds, settings.secondsPerCase, allocatedBytes);
+
+                    std::cout << column(juce::String(sampleRate, 0), 8) << column(juce::String(blockSize), 7) << column(juce::String(delaySeconds, 0), 9)
+                              << column(longDelay, 10) << column((double) allocatedBytes / (1024.0 * 1024.0), 9) << std::endl;
+                }
+            }
+        }
+
+        std::cout << std::endl << "processBlock with the cutoff automated every block, by automation granularity" << std::endl
+                  << column("rate", 8) << column("block", 7);
+
+        auto granularities = TableTennisAudioProcessor::getAutomationGranularities();
+
+        for (auto granularity : granularities)
+            std::cout << column(granularity > 0 ? juce::String(granularity) : juce::String("per block"), 11);
+
+        std::cout << std::endl;
+
+        for (auto sampleRate : settings.sampleRates)
+        {
+            for (auto blockSize : settings.blockSizes)
+            {
+                std::cout << column(juce::String(sampleRate, 0), 8) << column(juce::String(blockSize), 7);
+
+                for (auto granularity : granularities)
+                    std::cout << column(benchmarkAutomation(granularity, blockSize, sampleRate, settings.secondsPerCase), 11);
+
+                std::cout << std::endl;
+            }
+        }
+    }
+
+    //==============================================================================
+    void runStress(const StressSettings& settings)
+    {
+        auto numThreads = settings.numThreads > 0 ? settings.numThreads : juce::SystemStats::getNumCpus();
+        auto numCallbacks = juce::jmax(1, (int) (settings.secondsOfAudio * settings.sampleRate / settings.blockSize));
+        auto callbackSeconds = settings.blockSize / settings.sampleRate;
+        auto kilobytesPerInstance = [] (size_t after, size_t before, int numInstances) { return ((double) after - (double) before) / (1024.0 * numInstances); };
+
+        std::cout << "Many instances - stereo, " << juce::String(settings.sampleRate, 0) << " Hz, " << settings.blockSize << " sample blocks, "
+                  << settings.secondsOfAudio << " s of audio through each, on up to " << numThreads << " thread(s)" << std::endl
+                  << "Memory is the resident memory each instance adds, once created, once prepared and once released again" << std::endl
+                  << column("instances", 10) << column("create us", 11) << column("prepare us", 11) << column("created KB", 12)
+                  << column("prepared KB", 12) << column("released KB", 12) << column("cores", 8) << column("% each", 8)
+                  << column("mean cb %", 10) << column("worst cb %", 11) << std::endl;
+
+        for (auto numInstances : settings.instanceCounts)
+        {
+            juce::OwnedArray<TableTennisAudioProcessor> instances;
+            auto memoryBefore = getResidentBytes();
+
+            auto start = juce::Time::getHighResolutionTicks();
+
+            for (int i = 0; i < numInstances; ++i)
+                instances.add(new TableTennisAudioProcessor());
+
+            auto createSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+            auto memoryCreated = getResidentBytes();
+
+            start = juce::Time::getHighResolutionTicks();
+
+            for (auto* instance : instances)
+            {
+                instance->setPlayConfigDetails(numChannels, numChannels, settings.sampleRate, settings.blockSize);
+                instance->prepareToPlay(settings.sampleRate, settings.blockSize);
+            }
+
+            auto prepareSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+            auto memoryPrepared = getResidentBytes();
+
+            // Shared out round robin, so every worker gets as near the same number as it can
+            juce::OwnedArray<StressWorker> workers;
+            auto numWorkers = juce::jmin(numThreads, numInstances);
+
+            for (int w = 0; w < numWorkers; ++w)
+            {
+                juce::Array<TableTennisAudioProcessor*> share;
+
+                for (int i = w; i < numInstances; i += numWorkers)
+                    share.add(instances[i]);
+
+                workers.add(new StressWorker(share, settings.sampleRate, settings.blockSize, numCallbacks));
+            }
+
+            for (auto* worker : workers)
+                worker->startThread();
+
+            juce::int64 busyTicks = 0, worstCallbackTicks = 0;
+
+            for (auto* worker : workers)
+            {
+                worker->waitForThreadToExit(-1);
+                busyTicks += worker->busyTicks;
+                worstCallbackTicks = juce::jmax(worstCallbackTicks, worker->worstCallbackTicks);
+            }
+
+            for (auto* instance : instances)
+                instance->releaseResources();
+
+            auto memoryReleased = getResidentBytes();
+
+            auto audioSeconds = numCallbacks * callbackSeconds;
+            auto cores = juce::Time::highResolutionTicksToSeconds(busyTicks) / audioSeconds;
+            auto meanCallback = juce::Time::highResolutionTicksToSeconds(busyTicks) / ((double) numWorkers * numCallbacks * callbackSeconds);
+            auto worstCallback = juce::Time::highResolutionTicksToSeconds(worstCallbackTicks) / callbackSeconds;
+
+            std::cout << column(juce::String(numInstances), 10)
+                      << column(createSeconds * 1.0e6 / numInstances, 11) << column(prepareSeconds * 1.0e6 / numInstances, 11)
+                      << column(kilobytesPerInstance(memoryCreated, memoryBefore, numInstances), 12)
+                      << column(kilobytesPerInstance(memoryPrepared, memoryBefore, numInstances), 12)
+                      << column(kilobytesPerInstance(memoryReleased, memoryBefore, numInstances), 12)
+                      << column(cores, 8) << column(cores * 100.0 / numInstances, 8)
+                      << column(meanCallback * 100.0, 10) << column(worstCallback * 100.0, 11) << std::endl;
+        }
+    }
+}
@@ -0,0 +1,52 @@
+/*
+  ==============================================================================
+
+    Benchmarks.h
+
+    Micro-benchmarks for the DSP core: the wet filter, the delay kernel (on
+    each instruction set the CPU has), the long delay and the whole
+    processBlock (next to the frozen reference), over a matrix of block sizes,
+    sample rates and delay times.
+
+    Also a stress test of many instances at once - how long they take to
+    create, the memory each one holds, and the CPU they need together when
+    driven the way a host's engine drives them.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace Benchmarks
+{
+    struct Settings
+    {
+        double secondsPerCase = 1.0;                            // Audio processed per measurement, after a short warm up
+        juce::Array<int> blockSizes { 16, 64, 256, 1024, 4096 };
+        juce::Array<double> sampleRates { 44100.0, 48000.0, 96000.0, 192000.0 };
+        juce::Array<float> delayTimesMs { 10.0f, 375.0f, 3000.0f };
+        bool includeReference = true;                           // The reference is slow - leave it out for a quick run
+    };
+
+    /** Runs every benchmark and prints ns per sample frame (all channels of one sample) for each case. */
+    void run(const Settings& settings);
+
+    //==============================================================================
+    struct StressSettings
+    {
+        juce::Array<int> instanceCounts { 1, 10, 100, 1000 };
+        int numThreads = 0;                                     // Workers standing in for the host's audio threads - 0 for one per CPU core
+        double sampleRate = 48000.0;
+        int blockSize = 256;
+        double secondsOfAudio = 2.0;                            // Run through every instance
+    };
+
+    /** For each instance count: creates that many processors, prepares them, then runs them all in a simulated host loop, the
+        instances shared out between the worker threads and each worker processing all of its instances one block at a time.
+        Prints the time to create and prepare an instance, the resident memory each one adds (created, prepared and released),
+        and the CPU they need together - in cores, and as a share of the block period on the busiest worker.
+    */
+    void runStress(const StressSettings& settings);
+}
@@ -0,0 +1,1194 @@
+/*
+  ==============================================================================
+
+    GoldenTests.cpp
+
+    Golden-output tests: the optimised kernels and the whole processBlock are
+    run side by side with the frozen scalar reference in ReferenceDelay.h, on
+    the same noise, and every output sample has to agree within a tolerance.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+#include "ReferenceDelay.h"
+#include "TestSignals.h"
+
+namespace
+{
+    /** Largest allowed difference from the reference, per sample. Float is loose enough for a different summing order, not for a different sound. */
+    template <typename SampleType>
+    constexpr double getTolerance() { return std::is_same<SampleType, float>::value ? 1.0e-5 : 1.0e-12; }
+
+    juce::String getPrecisionName(bool isDouble) { return isDouble ? "double" : "float"; }
+}
+
+//==============================================================================
+/** PingPongKernel against Reference::Delay - every interpolation, tap pattern, channel count and code path. */
+class KernelEquivalenceTest : public juce::UnitTest
+{
+public:
+    KernelEquivalenceTest() : juce::UnitTest("PingPongKernel matches the reference", "TableTennis") {}
+
+    void runTest() override
+    {
+        for (auto path : { Path::settled, Path::ramped, Path::crossfade, Path::feedbackLoop, Path::wowFlutter, Path::latencyCompensation })
+        {
+            beginTest(getPathName(path));
+
+            for (int quality = 0; quality < DelayInterpolation::getQualityNames().size(); ++quality)
+                for (int pattern = 0; pattern < TapPatterns::getNames().size(); ++pattern)
+                    for (auto numChannels : { 1, 2, 6 })
+                        for (auto rotate : { false, true })
+                        {
+                            check<float>((DelayInterpolation::Quality) quality, pattern, numChannels, rotate, path);
+                            check<double>((DelayInterpolation::Quality) quality, pattern, numChannels, rotate, path);
+                        }
+        }
+
+        beginTest("Latency compensation only moves the first echo");
+        checkCompensatedEchoes<float>();
+        checkCompensatedEchoes<double>();
+    }
+
+private:
+    enum class Path
+    {
+        settled,    // Constant parameters - the SIMD path
+        ramped,     // Per-sample parameter arrays
+        crossfade,  // A delay time jump half way through
+        feedbackLoop, // Settled, with the low pass and soft clip inside the feedback loop
+        wowFlutter,   // A crossfade, with every tap's delay time modulated per sample
+        latencyCompensation // A crossfade, with the taps output early and fed back at the full delay
+    };
+
+    static juce::String getPathName(Path path)
+    {
+        return path == Path::settled ? "Settled parameters" : path == Path::ramped ? "Per-sample parameters"
+             : path == Path::crossfade ? "Crossfaded delay change" : path == Path::feedbackLoop ? "Filter in the feedback loop"
+             : path == Path::wowFlutter ? "Wow and flutter" : "Latency compensation";
+    }
+
+    template <typename SampleType>
+    void check(DelayInterpolation::Quality quality, int pattern, int numChannels, bool rotate, Path path)
+    {
+        constexpr int maxDelay = 44100, numBlocks = 40;
+        constexpr float feedback = 0.6f, wetGain = 0.8f;
+        constexpr double sampleRate = 44100.0;
+        constexpr float loopCutoff = 900.0f, loopQ = 2.0f;
+        constexpr float wow = 0.7f, flutter = 0.5f;
+        constexpr float latency = 3.4f; // About what the 4x oversampler adds
+
+        PingPongKernel<SampleType> kernel;
+        kernel.prepare(numChannels, maxDelay);
+        kernel.setTapTable(TapPatterns::get(pattern));
+
+        Reference::Delay<SampleType> reference;
+        reference.prepare(numChannels, maxDelay);
+        reference.setTapTable(TapPatterns::get(pattern));
+        reference.setQuality(quality);
+
+        if (path == Path::feedbackLoop)
+        {
+            auto& loop = kernel.getFeedbackLoop();
+            loop.setCutoffFrequency(loopCutoff);
+            loop.setResonance(loopQ);
+            loop.prepare(sampleRate, numChannels);
+            kernel.setFeedbackLoopEnabled(true);
+
+            auto g = std::tan(juce::MathConstants<SampleType>::pi * (SampleType) loopCutoff / (SampleType) sampleRate);
+            auto k1 = (SampleType) 1 / (SampleType) loopQ + g;
+            reference.setFeedbackLoop(true, g, k1, (SampleType) 1 / ((SampleType) 1 + g * k1));
+        }
+
+        if (path == Path::wowFlutter)
+        {
+            auto& modulation = kernel.getModulation();
+            modulation.prepare(sampleRate, numChannels);
+            modulation.setDepths(wow, flutter);
+            modulation.reset();
+
+            reference.setModulation(wow, flutter, sampleRate);
+        }
+
+        if (path == Path::latencyCompensation)
+        {
+            kernel.setLatencyCompensation(latency);
+            reference.setLatencyCompensation(latency);
+        }
+
+        auto& random = getRandom();
+        auto delay = 523.7f;
+        auto maxError = 0.0;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            auto numSamples = 1 + random.nextInt(600);
+
+            if ((path == Path::crossfade || path == Path::wowFlutter || path == Path::latencyCompensation) && block == numBlocks / 2)
+            {
+                kernel.startCrossfade(delay, 3000);
+                reference.startCrossfade(delay, 3000);
+                delay = 2222.2f;
+            }
+
+            juce::AudioBuffer<SampleType> buffer(numChannels, numSamples);
+            TestSignals::fillWithNoise(buffer, random);
+            juce::AudioBuffer<SampleType> expected(buffer);
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                SampleType frame[PingPongKernel<SampleType>::maxChannels];
+
+                for (int channel = 0; channel < numChannels; ++channel)
+                    frame[channel] = expected.getSample(channel, i);
+
+                reference.processFrame(frame, delay, feedback, wetGain, rotate);
+
+                for (int channel = 0; channel < numChannels; ++channel)
+                    expected.setSample(channel, i, frame[channel]);
+            }
+
+            if (path == Path::ramped)
+            {
+                std::vector<float> delays((size_t) numSamples, delay), feedbacks((size_t) numSamples, feedback), wetGains((size_t) numSamples, wetGain);
+                kernel.processWithQuality(quality, buffer.getArrayOfWritePointers(), numSamples, (const float*) delays.data(),
+                                          (const float*) feedbacks.data(), (const float*) wetGains.data(), rotate);
+            }
+            else
+            {
+                kernel.processWithQuality(quality, buffer.getArrayOfWritePointers(), numSamples, delay, feedback, wetGain, rotate);
+            }
+
+            maxError = juce::jmax(maxError, TestSignals::maxDifference(buffer, expected));
+        }
+
+        expect(maxError <= getTolerance<SampleType>(),
+               getPrecisionName(std::is_same<SampleType, double>::value) + ", " + DelayInterpolation::getQualityNames()[(int) quality]
+                 + ", " + TapPatterns::getNames()[pattern] + ", " + juce::String(numChannels) + " channel(s)"
+                 + (rotate ? ", ping-pong" : "") + ": max error " + juce::String(maxError));
+    }
+
+    /** An impulse through a compensated kernel - the first echo comes early, and every one after it a whole delay time later. */
+    template <typename SampleType>
+    void checkCompensatedEchoes()
+    {
+        constexpr int delay = 1000, latency = 3, numEchoes = 4;
+
+        PingPongKernel<SampleType> kernel;
+        kernel.prepare(1, 4 * delay);
+        kernel.setTapTable(TapPatterns::get(0));
+        kernel.setLatencyCompensation((float) latency);
+
+        juce::AudioBuffer<SampleType> buffer(1, numEchoes * delay + 1);
+        buffer.clear();
+        buffer.setSample(0, 0, (SampleType) 1);
+        kernel.template process<DelayInterpolation::None>(buffer.getArrayOfWritePointers(), buffer.getNumSamples(), (float) delay, 0.5f, 1.0f, false);
+
+        juce::Array<int> echoes;
+
+        for (int i = 0; i < buffer.getNumSamples(); ++i)
+            if (buffer.getSample(0, i) != SampleType())
+                echoes.add(i);
+
+        juce::Array<int> expected;
+
+        for (int echo = 1; echo <= numEchoes; ++echo)
+            expected.add(echo * delay - latency);
+
+        expect(echoes == expected, getPrecisionName(std::is_same<SampleType, double>::value) + ": echoes at " + juce::String(echoes.size()) + " places, first at "
+                                     + juce::String(echoes.isEmpty() ? -1 : echoes.getFirst()) + ", last at " + juce::String(echoes.isEmpty() ? -1 : echoes.getLast()));
+    }
+};
+
+static KernelEquivalenceTest kernelEquivalenceTest;
+
+//==============================================================================
+/** Every instruction set's build of SimdKernels against the scalar build. They do the same sums in the same order, so the delay
+    kernel has to come out bit for bit the same on each - and a forced instruction set has to be the one prepareToPlay picks.
+*/
+class KernelDispatchTest : public juce::UnitTest
+{
+public:
+    KernelDispatchTest() : juce::UnitTest("Every instruction set's kernels match the scalar ones", "TableTennis") {}
+
+    void runTest() override
+    {
+        using SimdKernels::Isa;
+
+        beginTest("Kernels on a CPU with " + juce::String(SimdKernels::getName(SimdKernels::getBestIsa())));
+
+        for (int i = 0; i < (int) Isa::numIsas; ++i)
+        {
+            auto isa = (Isa) i;
+
+            if (isa == Isa::scalar || ! SimdKernels::isSupported(isa))
+                continue;
+
+            // Thiran's taps are read in PingPongKernel whatever the instruction set, but the rest of its kernel isn't
+            for (auto quality : { DelayInterpolation::Quality::none, DelayInterpolation::Quality::linear,
+                                  DelayInterpolation::Quality::lagrange3, DelayInterpolation::Quality::thiran })
+                for (auto loopEnabled : { false, true })
+                    for (auto ramped : { false, true })
+                        for (auto numChannels : { 1, 2, 6 })
+                        {
+                            check<float>(isa, quality, loopEnabled, ramped, numChannels);
+                            check<double>(isa, quality, loopEnabled, ramped, numChannels);
+                        }
+
+            for (auto numChannels : { 1, 2, 6 })
+            {
+                checkFilter<float>(isa, numChannels);
+                checkFilter<double>(isa, numChannels);
+            }
+        }
+
+        beginTest("Forcing an instruction set");
+
+        for (int i = 0; i < (int) Isa::numIsas; ++i)
+        {
+            auto isa = (Isa) i;
+            SimdKernels::forceIsa(isa);
+
+            TableTennisAudioProcessor processor;
+            processor.setPlayConfigDetails(2, 2, 44100.0, 512);
+            processor.prepareToPlay(44100.0, 512);
+
+            auto expected = SimdKernels::isSupported(isa) ? isa : SimdKernels::getBestIsa(); // Ones the CPU can't run are ignored
+            expect(processor.getKernelIsa() == expected, juce::String("forced ") + SimdKernels::getName(isa) + ", got " + SimdKernels::getName(processor.getKernelIsa()));
+
+            processor.releaseResources();
+        }
+
+        SimdKernels::forceIsa(Isa::numIsas);
+    }
+
+private:
+    /** Runs the same noise through a scalar kernel and one on isa - settled or ramped, with a crossfade half way, and ping-pong on. */
+    template <typename SampleType>
+    void check(SimdKernels::Isa isa, DelayInterpolation::Quality quality, bool loopEnabled, bool ramped, int numChannels)
+    {
+        constexpr int maxDelay = 44100, numBlocks = 40;
+        constexpr double sampleRate = 44100.0;
+
+        PingPongKernel<SampleType> kernels[2];
+
+        for (auto& kernel : kernels)
+        {
+            kernel.prepare(numChannels, maxDelay);
+            kernel.setTapTable(TapPatterns::get(1)); // Panned taps, so both outputs of every tap get mixed
+            kernel.getFeedbackLoop().setCutoffFrequency(900.0f);
+            kernel.getFeedbackLoop().prepare(sampleRate, numChannels);
+            kernel.setFeedbackLoopEnabled(loopEnabled);
+        }
+
+        kernels[0].setIsa(SimdKernels::Isa::scalar);
+        kernels[1].setIsa(isa);
+
+        auto& random = getRandom();
+        auto delay = 523.7f;
+        auto maxError = 0.0;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            auto numSamples = 1 + random.nextInt(600);
+
+            if (block == numBlocks / 2)
+            {
+                for (auto& kernel : kernels)
+                    kernel.startCrossfade(delay, 3000);
+
+                delay = 2222.2f;
+            }
+
+            juce::AudioBuffer<SampleType> expected(numChannels, numSamples);
+            TestSignals::fillWithNoise(expected, random);
+            juce::AudioBuffer<SampleType> buffer(expected);
+
+            std::vector<float> delays((size_t) numSamples, delay), feedbacks((size_t) numSamples), wetGains((size_t) numSamples);
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                feedbacks[(size_t) i] = 0.5f + 0.3f * (float) i / (float) numSamples;
+                wetGains[(size_t) i] = 0.9f - 0.4f * (float) i / (float) numSamples;
+            }
+
+            for (auto* audio : { &expected, &buffer })
+            {
+                auto& kernel = kernels[audio == &expected ? 0 : 1];
+
+                if (ramped)
+                    kernel.processWithQuality(quality, audio->getArrayOfWritePointers(), numSamples, (const float*) delays.data(),
+                                              (const float*) feedbacks.data(), (const float*) wetGains.data(), true);
+                else
+                    kernel.processWithQuality(quality, audio->getArrayOfWritePointers(), numSamples, delay, 0.6f, 0.8f, true);
+            }
+
+            maxError = juce::jmax(maxError, TestSignals::maxDifference(buffer, expected));
+        }
+
+        expect(kernels[1].getIsa() == isa, juce::String("couldn't switch to ") + SimdKernels::getName(isa));
+        expect(maxError == 0.0, getPrecisionName(std::is_same<SampleType, double>::value) + ", " + SimdKernels::getName(isa) + ", "
+                                  + DelayInterpolation::getQualityNames()[(int) quality] + (loopEnabled ? ", feedback loop" : "") + (ramped ? ", ramped" : ", settled") + ", "
+                                  + juce::String(numChannels) + " channel(s): max difference " + juce::String(maxError));
+    }
+
+    /** The same for the wet filter - settled, then gliding to a new cutoff half way, then settled again. */
+    template <typename SampleType>
+    void checkFilter(SimdKernels::Isa isa, int numChannels)
+    {
+        constexpr int numBlocks = 40;
+
+        WetFilter<SampleType> filters[2];
+
+        for (auto& filter : filters)
+        {
+            filter.prepare({ 44100.0, 600, (juce::uint32) numChannels });
+            filter.setResonance(4.0f);
+            filter.reset();
+        }
+
+        filters[0].setKernels(SimdKernels::getTable<SampleType>(SimdKernels::Isa::scalar));
+        filters[1].setKernels(SimdKernels::getTable<SampleType>(isa));
+
+        auto& random = getRandom();
+        auto maxError = 0.0;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            auto numSamples = 1 + random.nextInt(600);
+
+            if (block == numBlocks / 2)
+                for (auto& filter : filters)
+                    filter.setCutoffFrequency(3000.0f);
+
+            juce::AudioBuffer<SampleType> expected(numChannels, numSamples);
+            TestSignals::fillWithNoise(expected, random);
+            juce::AudioBuffer<SampleType> buffer(expected);
+
+            filters[0].process(juce::dsp::AudioBlock<SampleType>(expected));
+            filters[1].process(juce::dsp::AudioBlock<SampleType>(buffer));
+
+            maxError = juce::jmax(maxError, TestSignals::maxDifference(buffer, expected));
+        }
+
+        expect(maxError == 0.0, getPrecisionName(std::is_same<SampleType, double>::value) + ", " + SimdKernels::getName(isa)
+                                  + ", wet filter, " + juce::String(numChannels) + " channel(s): max difference " + juce::String(maxError));
+    }
+};
+
+static KernelDispatchTest kernelDispatchTest;
+
+//==============================================================================
+/** PagedDelay against Reference::LongDelay, across page boundaries and through a freeze - and its memory only growing as far as it's used. */
+class LongDelayEquivalenceTest : public juce::UnitTest
+{
+public:
+    LongDelayEquivalenceTest() : juce::UnitTest("PagedDelay matches the reference", "TableTennis") {}
+
+    void runTest() override
+    {
+        beginTest("Constant delays");
+
+        // Inside one page, exactly one page either side of the boundary, and across several
+        for (auto delay : { 3000, PagedDelay<float>::pageFrames - 1, PagedDelay<float>::pageFrames, 20000 })
+            for (auto numChannels : { 1, 2, 6 })
+                for (auto rotate : { false, true })
+                {
+                    check<float>(delay, numChannels, rotate);
+                    check<double>(delay, numChannels, rotate);
+                }
+
+        beginTest("Latency compensation");
+
+        for (auto rotate : { false, true })
+        {
+            check<float>(20000, 2, rotate, 3);
+            check<double>(20000, 2, rotate, 3);
+        }
+
+        for (auto change : { Change::grow, Change::crossfade, Change::dryPool })
+        {
+            beginTest(getChangeName(change));
+
+            for (auto rotate : { false, true })
+            {
+                checkChange<float>(change, rotate);
+                checkChange<double>(change, rotate);
+            }
+        }
+
+        beginTest("Memory follows the delay time");
+
+        PagedDelay<float> delayLine;
+        delayLine.prepare(2, 60 * 44100, 0);
+        expectEquals((int) delayLine.getAllocatedBytes(), 0, "Allocated before the long delay was used");
+
+        // Nothing would echo if the pages weren't there, so an impulse coming back on time shows they were committed
+        constexpr int delay = 20000, blockSize = 512;
+        delayLine.setDelay(delay, 1);
+        delayLine.allocatePages(); // What the background thread does, without waiting for it
+
+        juce::AudioBuffer<float> buffer(2, blockSize);
+        auto echoAt = -1;
+
+        for (int block = 0; block < 100 && echoAt < 0; ++block)
+        {
+            buffer.clear();
+
+            if (block == 40) // Once the ring has grown past the first page
+                buffer.setSample(0, 0, 1.0f);
+
+            delayLine.process(buffer.getArrayOfWritePointers(), blockSize, 0.0f, 1.0f, false, false);
+
+            for (int i = 0; i < blockSize && echoAt < 0; ++i)
+                if (buffer.getSample(0, i) != 0.0f)
+                    echoAt = block * blockSize + i - 40 * blockSize;
+        }
+
+        auto numPages = delay / PagedDelay<float>::pageFrames + 1;
+        expectEquals(echoAt, delay, "Echo time");
+        expectEquals(delayLine.getNumCommittedPages(), numPages, "Pages in the ring");
+        expectEquals((int) delayLine.getAllocatedBytes(), (int) (numPages * PagedDelay<float>::pageFrames * 2 * sizeof(float)), "Bytes allocated");
+
+        beginTest("A reset empties the ring");
+
+        for (auto rotate : { false, true })
+        {
+            checkReset<float>(rotate);
+            checkReset<double>(rotate);
+        }
+
+        beginTest("Switched on mid-stream, it records straight away");
+        checkSwitchOn();
+        checkProcessorSwitchOn();
+    }
+
+private:
+    template <typename SampleType>
+    void check(int delay, int numChannels, bool rotate, int latencyCompensation = 0)
+    {
+        constexpr int numBlocks = 300;
+        constexpr float feedback = 0.7f, wetGain = 0.8f;
+
+        PagedDelay<SampleType> delayLine;
+        delayLine.prepare(numChannels, 60 * 44100, delay); // Allocates the pages up front, so nothing depends on the background thread
+        delayLine.setLatencyCompensation(latencyCompensation);
+
+        Reference::LongDelay<SampleType> reference;
+        reference.prepare(numChannels, delay, latencyCompensation);
+
+        auto& random = getRandom();
+        auto maxError = 0.0;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            auto numSamples = 1 + random.nextInt(700);
+            auto freeze = block > numBlocks * 2 / 3 && block < numBlocks * 5 / 6;
+
+            delayLine.setDelay(delay, 100);
+
+            juce::AudioBuffer<SampleType> buffer(numChannels, numSamples);
+
+            if (block < numBlocks / 2) // Then silence, so the loop has to carry on by itself
+                TestSignals::fillWithNoise(buffer, random);
+            else
+                buffer.clear();
+
+            juce::AudioBuffer<SampleType> expected(buffer);
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                SampleType frame[PagedDelay<SampleType>::maxChannels];
+
+                for (int channel = 0; channel < numChannels; ++channel)
+                    frame[channel] = expected.getSample(channel, i);
+
+                reference.processFrame(frame, feedback, wetGain, rotate, freeze);
+
+                for (int channel = 0; channel < numChannels; ++channel)
+                    expected.setSample(channel, i, frame[channel]);
+            }
+
+            delayLine.process(buffer.getArrayOfWritePointers(), numSamples, feedback, wetGain, rotate, freeze);
+            maxError = juce::jmax(maxError, TestSignals::maxDifference(buffer, expected));
+        }
+
+        expect(maxError <= getTolerance<SampleType>(),
+               getPrecisionName(std::is_same<SampleType, double>::value) + ", " + juce::String(delay) + " samples, "
+                 + juce::String(numChannels) + " channel(s)" + (rotate ? ", ping-pong" : "")
+                 + (latencyCompensation > 0 ? ", " + juce::String(latencyCompensation) + " early" : juce::String())
+                 + ": max error " + juce::String(maxError));
+    }
+
+    enum class Change
+    {
+        grow,       // A longer delay with the ring full of audio - held until the write head comes round to the end, then grown into
+        crossfade,  // Shorter and longer delays, one of them while the last crossfade is still going
+        dryPool     // A longer delay with no pages to grow into until a while later - whatever the write head missed comes back as silence
+    };
+
+    static juce::String getChangeName(Change change)
+    {
+        return change == Change::grow ? "Growing a ring that's holding audio" : change == Change::crossfade ? "Crossfaded delay changes"
+             : "Running out of pages";
+    }
+
+    template <typename SampleType>
+    void checkChange(Change change, bool rotate)
+    {
+        constexpr int numChannels = 2, numBlocks = 400, maxDelay = 40000, crossfadeLength = 3000;
+        constexpr float feedback = 0.7f, wetGain = 0.8f;
+        auto startDelay = change == Change::crossfade ? 20000 : 3000;
+
+        PagedDelay<SampleType> delayLine;
+        delayLine.prepare(numChannels, maxDelay, startDelay, 0, false); // No background thread - pages only come when the test asks for them
+
+        Reference::LongDelay<SampleType> reference;
+        reference.prepare(numChannels, startDelay, 0, maxDelay);
+
+        auto& random = getRandom();
+        auto maxError = 0.0;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            auto numSamples = 1 + random.nextInt(700);
+            auto delay = startDelay;
+
+            if (change == Change::crossfade)
+                delay = block < 60 ? 20000 : block < 62 ? 12000 : block < 120 ? 15000 : 20000; // The second change comes half way into the first's crossfade, so it waits
+            else if (block >= 50)
+                delay = 30000;
+
+            delayLine.setDelay(delay, crossfadeLength);
+            reference.setDelay(delay, crossfadeLength);
+
+            if (change != Change::dryPool || block == 150)
+            {
+                delayLine.allocatePages();
+                reference.allocate();
+            }
+
+            juce::AudioBuffer<SampleType> buffer(numChannels, numSamples);
+
+            if (block < numBlocks * 2 / 3) // Then silence, so the repeats get compared on their own too
+                TestSignals::fillWithNoise(buffer, random);
+            else
+                buffer.clear();
+
+            juce::AudioBuffer<SampleType> expected(buffer);
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                SampleType frame[PagedDelay<SampleType>::maxChannels];
+
+                for (int channel = 0; channel < numChannels; ++channel)
+                    frame[channel] = expected.getSample(channel, i);
+
+                reference.processFrame(frame, feedback, wetGain, rotate, false);
+
+                for (int channel = 0; channel < numChannels; ++channel)
+                    expected.setSample(channel, i, frame[channel]);
+            }
+
+            delayLine.process(buffer.getArrayOfWritePointers(), numSamples, feedback, wetGain, rotate, false);
+            maxError = juce::jmax(maxError, TestSignals::maxDifference(buffer, expected));
+        }
+
+        expect(maxError <= getTolerance<SampleType>(),
+               getPrecisionName(std::is_same<SampleType, double>::value) + (rotate ? ", ping-pong" : "") + ": max error " + juce::String(maxError));
+    }
+
+    /** The long delay switched on after being off since prepare(), the way the processor does it: nothing has asked for pages until
+        now, and the allocator hasn't looked in yet (here it never does). An impulse straight after the switch, and one at the end of
+        the time the allocator can take to notice, have to come back from the reserve - one from the first page, one from the ring's
+        first new page once it grows.
+    */
+    void checkSwitchOn()
+    {
+        constexpr double sampleRate = 44100.0;
+        constexpr int delay = 20000, blockSize = 512;
+        auto reserveFrames = PagedDelay<float>::getReserveFrames(sampleRate);
+
+        PagedDelay<float> delayLine;
+        delayLine.prepare(2, 60 * 44100, 0, reserveFrames, false);
+
+        delayLine.reset();
+        delayLine.setDelay(delay, 100);
+
+        juce::AudioBuffer<float> buffer(2, blockSize);
+
+        for (int start = 0; start < reserveFrames + delay + blockSize; start += blockSize)
+        {
+            buffer.clear();
+
+            for (auto impulseAt : { 0, reserveFrames - 1 })
+                if (impulseAt >= start && impulseAt < start + blockSize)
+                    buffer.setSample(0, impulseAt - start, 1.0f);
+
+            delayLine.process(buffer.getArrayOfWritePointers(), blockSize, 0.0f, 1.0f, false, false);
+
+            for (auto impulseAt : { 0, reserveFrames - 1 })
+                if (impulseAt + delay >= start && impulseAt + delay < start + blockSize)
+                    expectEquals(buffer.getSample(0, impulseAt + delay - start), 1.0f, "impulse " + juce::String(impulseAt) + " frames after the switch");
+        }
+    }
+
+    /** The same through the processor - Long delay switched on between two blocks, with an impulse at the start of the first one on. */
+    void checkProcessorSwitchOn()
+    {
+        constexpr double sampleRate = 44100.0;
+        constexpr int blockSize = 512;
+
+        ParameterSnapshot parameters;
+        parameters.feedback = 0.0f;
+        parameters.wetDry = 1.0f;          // Repeats only
+        parameters.lpf = 20000.0f;         // The long delay filters its input - next to nothing, here
+        parameters.longTimeSeconds = 1.0f;
+
+        TableTennisAudioProcessor processor;
+        processor.setPlayConfigDetails(1, 1, sampleRate, blockSize);
+        TestSignals::applyParameters(processor, parameters);
+        processor.prepareToPlay(sampleRate, blockSize);
+
+        juce::AudioBuffer<float> buffer(1, blockSize);
+        juce::MidiBuffer midi;
+
+        for (int block = 0; block < 20; ++block) // A while on the multi-tap delay first
+        {
+            buffer.clear();
+            processor.processBlock(buffer, midi);
+        }
+
+        parameters.longDelay = true;
+        TestSignals::applyParameters(processor, parameters);
+
+        auto delay = juce::roundToInt(parameters.longTimeSeconds * sampleRate);
+        auto peak = 0.0f;
+
+        for (int start = 0; start < delay + blockSize; start += blockSize)
+        {
+            buffer.clear();
+
+            if (start == 0)
+                buffer.setSample(0, 0, 1.0f);
+
+            processor.processBlock(buffer, midi);
+
+            for (int i = 0; i < blockSize; ++i)
+                if (std::abs(start + i - delay) < 100)
+                    peak = juce::jmax(peak, std::abs(buffer.getSample(0, i)));
+        }
+
+        processor.releaseResources();
+        expect(peak > 0.1f, "no echo of the first block after the switch: peak " + juce::String(peak));
+    }
+
+    /** A ring full of audio, reset half way round - from then on it has to sound like a new one, stale pages and all. */
+    template <typename SampleType>
+    void checkReset(bool rotate)
+    {
+        constexpr int delay = 20000, numChannels = 2, numBlocks = 200;
+        constexpr float feedback = 0.7f, wetGain = 0.8f;
+
+        PagedDelay<SampleType> delayLine;
+        delayLine.prepare(numChannels, 60 * 44100, delay);
+
+        Reference::LongDelay<SampleType> reference;
+        reference.prepare(numChannels, delay);
+
+        auto& random = getRandom();
+        auto maxError = 0.0;
+        auto silentAfterReset = false;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            auto numSamples = 1 + random.nextInt(700);
+
+            if (block == numBlocks / 2)
+            {
+                delayLine.reset();
+                reference.prepare(numChannels, delay);
+                silentAfterReset = delayLine.isSilent();
+            }
+
+            juce::AudioBuffer<SampleType> buffer(numChannels, numSamples);
+            TestSignals::fillWithNoise(buffer, random);
+            juce::AudioBuffer<SampleType> expected(buffer);
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                SampleType frame[PagedDelay<SampleType>::maxChannels];
+
+                for (int channel = 0; channel < numChannels; ++channel)
+                    frame[channel] = expected.getSample(channel, i);
+
+                reference.processFrame(frame, feedback, wetGain, rotate, false);
+
+                for (int channel = 0; channel < numChannels; ++channel)
+                    expected.setSample(channel, i, frame[channel]);
+            }
+
+            delayLine.setDelay(delay, 100);
+            delayLine.process(buffer.getArrayOfWritePointers(), numSamples, feedback, wetGain, rotate, false);
+
+            if (block >= numBlocks / 2)
+                maxError = juce::jmax(maxError, TestSignals::maxDifference(buffer, expected));
+        }
+
+        auto name = getPrecisionName(std::is_same<SampleType, double>::value) + (rotate ? ", ping-pong" : "");
+        expect(silentAfterReset, name + ": not silent after the reset");
+        expect(maxError <= getTolerance<SampleType>(), name + ": max error " + juce::String(maxError));
+    }
+};
+
+static LongDelayEquivalenceTest longDelayEquivalenceTest;
+
+//==============================================================================
+/** The whole processBlock against Reference::Processor, for every factory preset. */
+class ProcessorEquivalenceTest : public juce::UnitTest
+{
+public:
+    ProcessorEquivalenceTest() : juce::UnitTest("processBlock matches the reference", "TableTennis") {}
+
+    void runTest() override
+    {
+        for (auto sampleRate : { 44100.0, 96000.0 })
+        {
+            beginTest("Presets at " + juce::String(sampleRate / 1000.0) + "kHz");
+
+            for (int preset = 0; preset < PresetBank::getNumPresets(); ++preset)
+                for (auto numChannels : { 1, 2, 6 })
+                {
+                    check<float>(preset, numChannels, sampleRate);
+                    check<double>(preset, numChannels, sampleRate);
+                }
+        }
+
+        beginTest("Presets rendered offline");
+
+        for (int preset = 0; preset < PresetBank::getNumPresets(); ++preset)
+        {
+            check<float>(preset, 2, 44100.0, true);
+            check<double>(preset, 2, 44100.0, true);
+        }
+    }
+
+private:
+    template <typename SampleType>
+    void check(int preset, int numChannels, double sampleRate, bool offline = false)
+    {
+        constexpr int blockSize = 512, numBlocks = 100;
+        constexpr bool isDouble = std::is_same<SampleType, double>::value;
+
+        TableTennisAudioProcessor processor;
+        processor.setPlayConfigDetails(numChannels, numChannels, sampleRate, blockSize);
+
+        if (processor.getTotalNumOutputChannels() != numChannels)
+        {
+            expect(false, juce::String(numChannels) + " channels not supported");
+            return;
+        }
+
+        processor.setProcessingPrecision(isDouble ? juce::AudioProcessor::doublePrecision : juce::AudioProcessor::singlePrecision);
+        processor.setNonRealtime(offline);
+
+        // Settled parameters have to sound the same whatever the automation sub-blocks are, so the presets take turns at each
+        auto granularities = TableTennisAudioProcessor::getAutomationGranularities();
+        auto granularity = granularities[preset % granularities.size()];
+        processor.setAutomationGranularity(granularity);
+        TestSignals::applyParameters(processor, PresetBank::get(preset).parameters);
+        processor.prepareToPlay(sampleRate, blockSize);
+
+        // The reference gets exactly the values the processor sees, after the parameters' own rounding - and offline, its better interpolation and oversampling
+        auto parameters = processor.captureParameters();
+
+        if (offline)
+        {
+            parameters.quality = RenderQuality::getOfflineInterpolation(parameters.quality);
+            parameters.oversampling = RenderQuality::getOfflineOversampling(parameters.oversampling);
+        }
+
+        Reference::Processor<SampleType> reference;
+        reference.prepare(sampleRate, numChannels);
+        reference.setParameters(parameters);
+
+        auto& random = getRandom();
+        juce::MidiBuffer midi;
+        auto maxError = 0.0;
+
+        RealtimeSafety::resetViolations();
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            auto numSamples = 1 + random.nextInt(blockSize); // Hosts don't always send full blocks
+            juce::AudioBuffer<SampleType> buffer(numChannels, numSamples);
+
+            if (block < numBlocks / 2) // Then silence, so the repeats dying away get compared too
+                TestSignals::fillWithNoise(buffer, random);
+            else
+                buffer.clear();
+
+            juce::AudioBuffer<SampleType> expected(buffer);
+
+            processor.processBlock(buffer, midi);
+            reference.process(expected);
+
+            maxError = juce::jmax(maxError, TestSignals::maxDifference(buffer, expected));
+        }
+
+        processor.releaseResources();
+
+        expect(maxError <= getTolerance<SampleType>(),
+               getPrecisionName(isDouble) + ", " + PresetBank::get(preset).name + ", " + juce::String(numChannels)
+                 + " channel(s)" + (offline ? ", offline" : "") + ", automation every " + (granularity > 0 ? juce::String(granularity) + " samples" : juce::String("block"))
+                 + ": max error " + juce::String(maxError));
+
+        if (RealtimeSafety::getNumViolations() > 0) // Only ever counted in checked (Debug) builds
+            expect(false, "processBlock allocated or locked: " + juce::String(RealtimeSafety::getFirstViolation()));
+    }
+};
+
+static ProcessorEquivalenceTest processorEquivalenceTest;
+
+//==============================================================================
+/** A cutoff automated within one long block lands on every sub-block, not just the block - against a reference that's given the
+    values part of the way along, every granularity samples, the way the processor interpolates them.
+*/
+class AutomationGranularityTest : public juce::UnitTest
+{
+public:
+    AutomationGranularityTest() : juce::UnitTest("Automation within a block", "TableTennis") {}
+
+    void runTest() override
+    {
+        beginTest("A cutoff sweep in one block");
+
+        for (auto granularity : TableTennisAudioProcessor::getAutomationGranularities())
+        {
+            check<float>(granularity);
+            check<double>(granularity);
+        }
+
+        // A sweep applied once per block lands on the new cutoff at the start of the block - in sub-blocks it gets there by steps
+        expect(getSweepDifference(32, 0) > 1.0e-3, "automation every 32 samples came out the same as once per block");
+    }
+
+private:
+    static constexpr double sampleRate = 48000.0;
+    static constexpr int blockSize = 4096, numSettleBlocks = 10, numAfterBlocks = 4;
+    static constexpr float fromCutoff = 300.0f, toCutoff = 8000.0f;
+
+    /** Noise through the processor, with the cutoff moved from fromCutoff to toCutoff in the host's one block. */
+    template <typename SampleType>
+    static std::vector<juce::AudioBuffer<SampleType>> processSweep(int granularity, std::vector<juce::AudioBuffer<SampleType>>* expected)
+    {
+        constexpr bool isDouble = std::is_same<SampleType, double>::value;
+        constexpr int numChannels = 2;
+
+        ParameterSnapshot parameters;
+        parameters.lpf = fromCutoff;
+        parameters.q = 2.0f;
+        parameters.wetDry = 0.5f;
+
+        TableTennisAudioProcessor processor;
+        processor.setPlayConfigDetails(numChannels, numChannels, sampleRate, blockSize);
+        processor.setProcessingPrecision(isDouble ? juce::AudioProcessor::doublePrecision : juce::AudioProcessor::singlePrecision);
+        processor.setAutomationGranularity(granularity);
+        TestSignals::applyParameters(processor, parameters);
+        processor.prepareToPlay(sampleRate, blockSize);
+
+        Reference::Processor<SampleType> reference;
+        reference.prepare(sampleRate, numChannels);
+        reference.setParameters(processor.captureParameters());
+
+        juce::Random random(0x5eed);
+        juce::MidiBuffer midi;
+        std::vector<juce::AudioBuffer<SampleType>> outputs;
+
+        for (int block = 0; block < numSettleBlocks + 1 + numAfterBlocks; ++block)
+        {
+            auto from = processor.captureParameters();
+
+            if (block == numSettleBlocks)
+            {
+                parameters.lpf = toCutoff;
+                TestSignals::applyParameters(processor, parameters);
+            }
+
+            auto to = processor.captureParameters();
+
+            juce::AudioBuffer<SampleType> buffer(numChannels, blockSize);
+            TestSignals::fillWithNoise(buffer, random);
+
+            if (expected != nullptr)
+            {
+                // The reference is handed each sub-block's share of the way from the last block's cutoff to this one's
+                juce::AudioBuffer<SampleType> expectedBlock(buffer);
+                auto subBlockSize = granularity > 0 ? granularity : blockSize;
+
+                for (int start = 0; start < blockSize; start += subBlockSize)
+                {
+                    auto length = juce::jmin(subBlockSize, blockSize - start);
+                    juce::AudioBuffer<SampleType> subBlock(expectedBlock.getArrayOfWritePointers(), numChannels, start, length);
+
+                    reference.setCutoff(ParameterSnapshot::interpolate(from, to, (float) (start + length) / (float) blockSize).lpf);
+                    reference.process(subBlock);
+                }
+
+                expected->push_back(expectedBlock);
+            }
+
+            processor.processBlock(buffer, midi);
+            outputs.push_back(buffer);
+        }
+
+        processor.releaseResources();
+        return outputs;
+    }
+
+    template <typename SampleType>
+    void check(int granularity)
+    {
+        std::vector<juce::AudioBuffer<SampleType>> expected;
+        auto outputs = processSweep<SampleType>(granularity, &expected);
+        auto maxError = 0.0;
+
+        for (size_t block = 0; block < outputs.size(); ++block)
+            maxError = juce::jmax(maxError, TestSignals::maxDifference(outputs[block], expected[block]));
+
+        expect(maxError <= getTolerance<SampleType>(),
+               getPrecisionName(std::is_same<SampleType, double>::value) + ", automation every "
+                 + (granularity > 0 ? juce::String(granularity) + " samples" : juce::String("block")) + ": max error " + juce::String(maxError));
+    }
+
+    /** Largest difference in the swept block between two granularities. */
+    static double getSweepDifference(int granularity, int otherGranularity)
+    {
+        auto outputs = processSweep<float>(granularity, nullptr);
+        auto otherOutputs = processSweep<float>(otherGranularity, nullptr);
+        return TestSignals::maxDifference(outputs[(size_t) numSettleBlocks], otherOutputs[(size_t) numSettleBlocks]);
+    }
+};
+
+static AutomationGranularityTest automationGranularityTest;
+
+//==============================================================================
+/** Tempo sync - echoes land on the host's beat, and a tempo change crossfades to the new time instead of sweeping the pitch there. */
+class TempoSyncTest : public juce::UnitTest
+{
+public:
+    TempoSyncTest() : juce::UnitTest("Tempo sync and crossfaded time changes", "TableTennis") {}
+
+    void runTest() override
+    {
+        beginTest("Echoes land on the division at the host tempo");
+
+        for (auto bpm : { 90.0, 150.0 })
+            for (auto division : { 4, 8, 9 }) // 1/4, 1/8 dotted, 1/8 triplet
+                checkEchoTime(bpm, division);
+
+        beginTest("A tempo change crossfades rather than gliding");
+
+        // A head that glides to a shorter time reads faster than the audio was written - the repeats go up in pitch, so the
+        // output moves further from one sample to the next than the steady sine ever does. A crossfade never speeds up
+        expect(getTransitionSlewRatio(TempoSync::Transition::crossfade) < 1.1, "crossfade changed the pitch");
+        expect(getTransitionSlewRatio(TempoSync::Transition::glide) > 1.5, "glide didn't sweep the pitch - the test can't tell them apart");
+
+        beginTest("A tempo ramp crossfades one change at a time");
+
+        // The tempo moves every block, quicker than a crossfade finishes - restarting the fade each time would cut off a head part way
+        // through. The delay still has to end up at the final tempo's time
+        expect(getTransitionSlewRatio(TempoSync::Transition::crossfade, true) < 1.1, "the ramp clicked");
+    }
+
+private:
+    /** Reports a fixed tempo, as a host's play head would. */
+    struct FixedTempoPlayHead : public juce::AudioPlayHead
+    {
+        bool getCurrentPosition(CurrentPositionInfo& result) override
+        {
+            result.resetToDefault();
+            result.bpm = bpm;
+            return true;
+        }
+
+        double bpm = TempoSync::defaultBpm;
+    };
+
+    static ParameterSnapshot getSyncedParameters(int division, TempoSync::Transition transition)
+    {
+        ParameterSnapshot parameters;
+        parameters.sync = true;
+        parameters.division = division;
+        parameters.transition = transition;
+        parameters.feedback = 0.0f;
+        parameters.wetDry = 1.0f;        // Repeats only
+        parameters.loopFilter = true;    // The input goes into the delay unfiltered, and nothing comes back round
+        return parameters;
+    }
+
+    void checkEchoTime(double bpm, int division)
+    {
+        constexpr double sampleRate = 44100.0;
+        constexpr int blockSize = 512;
+
+        FixedTempoPlayHead playHead;
+        playHead.bpm = bpm;
+
+        TableTennisAudioProcessor processor;
+        processor.setPlayConfigDetails(1, 1, sampleRate, blockSize);
+        processor.setPlayHead(&playHead);
+        TestSignals::applyParameters(processor, getSyncedParameters(division, TempoSync::Transition::crossfade));
+        processor.prepareToPlay(sampleRate, blockSize);
+
+        auto expectedDelay = juce::roundToInt(TempoSync::getDelayMs(division, bpm) * sampleRate / 1000.0);
+        auto echoAt = getEchoTime(processor, expectedDelay + blockSize);
+        processor.releaseResources();
+
+        expectEquals(echoAt, expectedDelay, TempoSync::getDivisions()[(size_t) division].name + juce::String(" at ") + juce::String(bpm) + " BPM");
+    }
+
+    /** Sends an impulse through a processor with an empty delay and returns how long its echo takes - or -1 if it
+        doesn't come out within maxSamples.
+    */
+    static int getEchoTime(TableTennisAudioProcessor& processor, int maxSamples)
+    {
+        auto blockSize = processor.getBlockSize();
+        juce::AudioBuffer<float> buffer(1, blockSize);
+        juce::MidiBuffer midi;
+
+        for (int start = 0; start < maxSamples; start += blockSize)
+        {
+            buffer.clear();
+
+            if (start == 0)
+                buffer.setSample(0, 0, 1.0f);
+
+            processor.processBlock(buffer, midi);
+
+            for (int i = 0; i < blockSize; ++i)
+                if (std::abs(buffer.getSample(0, i)) > 0.5f)
+                    return start + i;
+        }
+
+        return -1;
+    }
+
+    /** The largest sample to sample step in the output across a change from 120 to 150 BPM, over the largest step
+        before it. A 440Hz sine goes in, so the steady output is that sine, a quarter note late. With ramp set the
+        tempo gets there a little every block, over numRampBlocks.
+    */
+    double getTransitionSlewRatio(TempoSync::Transition transition, bool ramp = false)
+    {
+        constexpr double sampleRate = 44100.0;
+        constexpr int blockSize = 512, numSteadyBlocks = 100, numTransitionBlocks = 40, numRampBlocks = 30; // About 1.2s, then 0.5s
+
+        FixedTempoPlayHead playHead;
+
+        TableTennisAudioProcessor processor;
+        processor.setPlayConfigDetails(1, 1, sampleRate, blockSize);
+        processor.setPlayHead(&playHead);
+        TestSignals::applyParameters(processor, getSyncedParameters(TempoSync::defaultDivision, transition));
+        processor.prepareToPlay(sampleRate, blockSize);
+
+        juce::AudioBuffer<float> buffer(1, blockSize);
+        juce::MidiBuffer midi;
+        auto phase = 0.0, steadySlew = 0.0, transitionSlew = 0.0;
+        auto previous = 0.0f;
+
+        for (int block = 0; block < numSteadyBlocks + numTransitionBlocks; ++block)
+        {
+            if (block >= numSteadyBlocks)
+                playHead.bpm = ramp ? 120.0 + 30.0 * juce::jmin(1.0, (double) (block - numSteadyBlocks + 1) / (double) numRampBlocks) : 150.0;
+
+            for (int i = 0; i < blockSize; ++i, phase += juce::MathConstants<double>::twoPi * 440.0 / sampleRate)
+                buffer.setSample(0, i, (float) (0.5 * std::sin(phase)));
+
+            processor.processBlock(buffer, midi);
+
+            for (int i = 0; i < blockSize; ++i)
+            {
+                auto sample = buffer.getSample(0, i);
+                auto slew = (double) std::abs(sample - previous);
+                previous = sample;
+
+                if (block >= numSteadyBlocks)
+                    transitionSlew = juce::jmax(transitionSlew, slew);
+                else if (block * blockSize > 23000) // Once the first echoes are through
+                    steadySlew = juce::jmax(steadySlew, slew);
+            }
+        }
+
+        expectEquals(processor.getHostBpm(), 150.0, "tempo not read from the play head");
+
+        // Silence until the sine's repeats have gone (nothing feeds back), then an impulse
+        auto delay = juce::roundToInt(TempoSync::getDelayMs(TempoSync::defaultDivision, 150.0) * sampleRate / 1000.0);
+        for (int start = 0; start < delay + blockSize; start += blockSize)
+        {
+            buffer.clear();
+            processor.processBlock(buffer, midi);
+        }
+
+        expectEquals(getEchoTime(processor, delay + blockSize), delay, "not at the new tempo's time");
+        processor.releaseResources();
+
+        return steadySlew > 0.0 ? transitionSlew / steadySlew : 0.0;
+    }
+};
+
+static TempoSyncTest tempoSyncTest;
+
+//==============================================================================
+/** The saved state - recalled exactly, and a damaged one never zeroing the parameters it doesn't hold. */
+class StateRecallTest : public juce::UnitTest
+{
+public:
+    StateRecallTest() : juce::UnitTest("Saved state", "TableTennis") {}
+
+    void runTest() override
+    {
+        auto preset = PresetBank::get(1).parameters;
+        juce::MemoryBlock state;
+
+        {
+            TableTennisAudioProcessor processor;
+            TestSignals::applyParameters(processor, preset);
+            processor.getStateInformation(state);
+        }
+
+        beginTest("Recalls every parameter");
+
+        {
+            TableTennisAudioProcessor processor;
+            processor.setStateInformation(state.getData(), (int) state.getSize());
+            expectValues(processor, preset.toValues(), ParameterSnapshot::numValues);
+        }
+
+        beginTest("A truncated state keeps the defaults for what's missing");
+
+        // The header and the first two values - delay time and feedback - then nothing, though it still claims every value
+        constexpr int numKept = 2;
+
+        auto expected = ParameterSnapshot().toValues();
+        std::copy_n(preset.toValues().begin(), numKept, expected.begin());
+
+        TableTennisAudioProcessor processor;
+        processor.setStateInformation(state.getData(), 16 + numKept * (int) sizeof(float));
+        expectValues(processor, expected, numKept);
+    }
+
+private:
+    /** Every parameter against the values expected, give or take the parameters' own rounding. */
+    void expectValues(TableTennisAudioProcessor& processor, const std::array<float, ParameterSnapshot::numValues>& expected, int numFromState)
+    {
+        auto values = processor.captureParameters().toValues();
+
+        for (int i = 0; i < ParameterSnapshot::numValues; ++i)
+            expectWithinAbsoluteError(values[(size_t) i], expected[(size_t) i], 0.01f,
+                                      juce::String(ParameterSnapshot::parameterIDs[i]) + (i < numFromState ? " from the state" : " left at its default"));
+    }
+};
+
+static StateRecallTest stateRecallTest;
@@ -0,0 +1,105 @@
+/*
+  ==============================================================================
+
+    This file contains the basic startup code for a JUCE application.
+
+    TableTennisTests - golden-output tests and micro-benchmarks for the DSP
+    core. Every optimisation has to keep the tests passing (same sound) and
+    show its gain in the benchmark tables (faster).
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "Benchmarks.h"
+
+//==============================================================================
+static void printUsage()
+{
+    std::cout << "Usage: TableTennisTests [options]" << std::endl
+              << std::endl
+              << "  (no options)            Run the golden-output tests" << std::endl
+              << "  --bench                 Run the benchmarks instead" << std::endl
+              << "  --all                   Run the tests, then the benchmarks" << std::endl
+              << "  --stress                Run many instances at once instead, and report their memory and CPU" << std::endl
+              << "  --instances=<n>         Most instances for --stress (default: 1, 10, 100 and 1000)" << std::endl
+              << "  --threads=<n>           Worker threads for --stress (default: one per CPU)" << std::endl
+              << "  --seconds=<n>           Audio processed per benchmark case, or per instance with --stress (default: 1, 2 with --stress)" << std::endl
+              << "  --quick                 Benchmark stereo 48kHz at 64 and 512 samples only, without the reference" << std::endl
+              << "  --seed=<n>              Random seed for the tests (default: fixed)" << std::endl;
+}
+
+static bool runTests(juce::int64 seed)
+{
+    juce::UnitTestRunner runner;
+    runner.setAssertOnFailure(false);
+    runner.runTestsInCategory("TableTennis", seed);
+
+    auto failures = 0;
+
+    for (int i = 0; i < runner.getNumResults(); ++i)
+        failures += runner.getResult(i)->failures;
+
+    std::cout << (failures == 0 ? "All tests passed" : juce::String(failures) + " test failure(s)") << std::endl;
+    return failures == 0;
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser; // Parameters and the value tree expect a message manager to exist
+
+    juce::ArgumentList args(argc, argv);
+
+    if (args.containsOption("--help|-h"))
+    {
+        printUsage();
+        return 0;
+    }
+
+    auto bench = args.containsOption("--bench|--all");
+    auto stress = args.containsOption("--stress");
+    auto test = ! args.containsOption("--bench|--stress") || args.containsOption("--all");
+    auto passed = true;
+
+    if (test)
+        passed = runTests(args.containsOption("--seed") ? args.getValueForOption("--seed").getLargeIntValue() : 0x7ab1e7e5);
+
+    if (bench)
+    {
+        Benchmarks::Settings settings;
+
+        if (args.containsOption("--seconds"))
+            settings.secondsPerCase = juce::jmax(0.01, args.getValueForOption("--seconds").getDoubleValue());
+
+        if (args.containsOption("--quick"))
+        {
+            settings.blockSizes = { 64, 512 };
+            settings.sampleRates = { 48000.0 };
+            settings.includeReference = false;
+        }
+
+        Benchmarks::run(settings);
+    }
+
+    if (stress)
+    {
+        Benchmarks::StressSettings settings;
+
+        if (args.containsOption("--instances"))
+        {
+            auto maxInstances = juce::jlimit(1, 1000, args.getValueForOption("--instances").getIntValue());
+            settings.instanceCounts.removeIf([=] (int count) { return count >= maxInstances; });
+            settings.instanceCounts.add(maxInstances);
+        }
+
+        if (args.containsOption("--threads"))
+            settings.numThreads = juce::jmax(1, args.getValueForOption("--threads").getIntValue());
+
+        if (args.containsOption("--seconds"))
+            settings.secondsOfAudio = juce::jmax(0.01, args.getValueForOption("--seconds").getDoubleValue());
+
+        Benchmarks::runStress(settings);
+    }
+
+    return passed ? 0 : 1;
+}
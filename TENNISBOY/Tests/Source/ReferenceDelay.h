@@ -0,0 +1,595 @@
+/*
+  ==============================================================================
+
+    ReferenceDelay.h
+
+    A frozen, deliberately plain copy of what the plugin does to the audio -
+    the golden reference the optimised kernels are checked against. One
+    frame, one channel and one tap at a time, straight out of a per-channel
+    history with a modulo index: no SIMD, no chunking, no mirrored ring, no
+    silence skipping.
+
+    Don't optimise anything in here. If the plugin's sound is meant to change,
+    change this in the same commit and say why.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../Source/ParameterSnapshot.h"
+#include "../../Source/DelayTaps.h"
+#include "../../Source/WowFlutter.h"
+
+namespace Reference
+{
+    //==============================================================================
+    /** The multi-tap delay on its own - the reference for PingPongKernel. */
+    template <typename SampleType>
+    class Delay
+    {
+    public:
+        void prepare(int numChannelsToUse, int maximumDelayInSamples)
+        {
+            numChannels = numChannelsToUse;
+            maxDelay = maximumDelayInSamples;
+            history.assign((size_t) numChannels, std::vector<SampleType>((size_t) (maxDelay + 8), SampleType()));
+            reset();
+        }
+
+        void reset()
+        {
+            for (auto& lane : history)
+                std::fill(lane.begin(), lane.end(), SampleType());
+
+            for (auto& lanes : state)
+                for (auto& s : lanes)
+                    s = SampleType();
+
+            for (auto& lanes : feedbackState)
+                for (auto& s : lanes)
+                    s = SampleType();
+
+            fadeLength = fadePosition = 0;
+            frame = 0;
+            wowPhase = flutterPhase = 0.0f;
+
+            std::fill(std::begin(loop1), std::end(loop1), SampleType());
+            std::fill(std::begin(loop2), std::end(loop2), SampleType());
+        }
+
+        void setTapTable(const TapTable& newTable) { table = newTable.sanitised(); }
+
+        /** Switches the in-loop low pass and soft clip on, with the filter's g, (1/Q + g) and 1 / (1 + g(1/Q + g)). */
+        void setFeedbackLoop(bool enabled, SampleType g, SampleType k1, SampleType h)
+        {
+            loopEnabled = enabled;
+            loopG = g;
+            loopK1 = k1;
+            loopH = h;
+        }
+        void setQuality(DelayInterpolation::Quality newQuality) { quality = newQuality; }
+
+        /** Wow and flutter amounts, 0 to 1, as WowFlutter::setDepths. Only WowFlutter's rate and depth constants are used from it. */
+        void setModulation(float wowAmount, float flutterAmount, double sampleRate)
+        {
+            wowDepth = wowAmount * (float) (WowFlutter::maxWowMs * sampleRate / 2000.0);
+            flutterDepth = flutterAmount * (float) (WowFlutter::maxFlutterMs * sampleRate / 2000.0);
+            wowIncrement = (float) (WowFlutter::wowRateHz / sampleRate);
+            flutterIncrement = (float) (WowFlutter::flutterRateHz / sampleRate);
+        }
+
+        /** The taps are output this many samples early, the feedback still reads them at the full delay. */
+        void setLatencyCompensation(float samples)
+        {
+            if (samples > 0.0f && latencyCompensation <= 0.0f)
+                feedbackState = state;
+
+            latencyCompensation = juce::jmax(0.0f, samples);
+        }
+
+        void startCrossfade(float fromDelay, int lengthInSamples)
+        {
+            fadeState = state;
+            fadeFeedbackState = feedbackState;
+            fadeFromDelay = fromDelay;
+            fadeLength = juce::jmax(1, lengthInSamples);
+            fadePosition = 0;
+        }
+
+        /** Processes one frame in place. delay is the Delay Time in samples. */
+        void processFrame(SampleType* frameData, float delay, float feedback, float wetGain, bool rotate)
+        {
+            SampleType toWrite[16], output[16] = {}, fed[16] = {};
+            float offset[16] = {};
+            auto fading = fadePosition < fadeLength;
+            auto fadeIn = fading ? (SampleType) juce::jmin(1.0f, (float) (fadePosition + 1) / (float) fadeLength) : SampleType(1);
+
+            for (int c = 0; c < numChannels; ++c)
+                toWrite[c] = frameData[c];
+
+            // Wow and flutter - each channel a quarter cycle on from the last, never shortening the delay
+            if (wowDepth > 0.0f || flutterDepth > 0.0f)
+            {
+                for (int c = 0; c < numChannels; ++c)
+                {
+                    auto lanePhase = (float) (c % 4) * 0.25f;
+                    offset[c] = wowDepth * (1.0f + sine(wowPhase + lanePhase)) + flutterDepth * (1.0f + sine(flutterPhase + lanePhase));
+                }
+
+                wowPhase += wowIncrement;
+                flutterPhase += flutterIncrement;
+
+                if (wowPhase >= 1.0f) wowPhase -= 1.0f;
+                if (flutterPhase >= 1.0f) flutterPhase -= 1.0f;
+            }
+
+            for (int t = 0; t < table.numTaps; ++t)
+            {
+                auto& tap = table.taps[(size_t) t];
+                auto angle = tap.pan * juce::MathConstants<float>::halfPi;
+                auto ownGain = numChannels == 1 ? tap.gain : (tap.pan == 0.0f ? tap.gain : tap.gain * std::cos(angle));
+                auto nextGain = numChannels == 1 || tap.pan == 0.0f ? 0.0f : tap.gain * std::sin(angle);
+
+                for (int c = 0; c < numChannels; ++c)
+                {
+                    // The output is read latencyCompensation early, the feedback at the full delay - the same read while there's none
+                    auto d = tapDelay(delay + offset[c], tap, c), fadeD = tapDelay(fadeFromDelay + offset[c], tap, c);
+                    auto compensating = latencyCompensation > 0.0f;
+
+                    auto value = read(c, juce::jmax(0.0f, d - latencyCompensation), state[(size_t) t][(size_t) c]);
+                    auto fedBack = compensating ? read(c, d, feedbackState[(size_t) t][(size_t) c]) : value;
+
+                    if (fading)
+                    {
+                        auto old = read(c, juce::jmax(0.0f, fadeD - latencyCompensation), fadeState[(size_t) t][(size_t) c]);
+                        auto oldFedBack = compensating ? read(c, fadeD, fadeFeedbackState[(size_t) t][(size_t) c]) : old;
+                        value = old + fadeIn * (value - old);
+                        fedBack = oldFedBack + fadeIn * (fedBack - oldFedBack);
+                    }
+
+                    output[c] += value * (SampleType) ownGain;
+                    output[(c + 1) % numChannels] += value * (SampleType) nextGain;
+                    fed[(c + tap.feedbackTo + (rotate ? 1 : 0)) % numChannels] += fedBack * (SampleType) (feedback * tap.feedback);
+                }
+            }
+
+            for (int c = 0; c < numChannels; ++c)
+            {
+                if (loopEnabled)
+                {
+                    auto hp = (fed[c] - loopK1 * loop1[c] - loop2[c]) * loopH;
+                    auto bp = loopG * hp + loop1[c];
+                    loop1[c] = loopG * hp + bp;
+                    auto lp = loopG * bp + loop2[c];
+                    loop2[c] = loopG * bp + lp;
+
+                    auto x = juce::jlimit((SampleType) -3, (SampleType) 3, lp);
+                    fed[c] = x * ((SampleType) 27 + x * x) / ((SampleType) 27 + (SampleType) 9 * x * x);
+                }
+
+                toWrite[c] += fed[c];
+            }
+
+            for (int c = 0; c < numChannels; ++c)
+            {
+                history[(size_t) c][(size_t) (frame % (int) history[(size_t) c].size())] = toWrite[c];
+                frameData[c] = output[c] * (SampleType) wetGain;
+            }
+
+            ++frame;
+
+            if (fading)
+                ++fadePosition;
+        }
+
+    private:
+        /** sin(2 pi phase) from a 1024 point table with linear interpolation - the modulation's sound depends on the table, not just on sin. */
+        static float sine(float phase)
+        {
+            static std::vector<float> table = []
+            {
+                std::vector<float> points;
+
+                for (int i = 0; i <= WowFlutter::tableSize; ++i)
+                    points.push_back((float) std::sin(juce::MathConstants<double>::twoPi * (i % WowFlutter::tableSize) / WowFlutter::tableSize));
+
+                return points;
+            }();
+
+            if (phase >= 1.0f)
+                phase -= 1.0f;
+
+            auto position = phase * (float) WowFlutter::tableSize;
+            auto index = (int) position;
+            auto frac = position - (float) index;
+            return table[(size_t) index] + frac * (table[(size_t) index + 1] - table[(size_t) index]);
+        }
+
+        float tapDelay(float delay, const DelayTap& tap, int channel) const
+        {
+            auto d = delay * tap.ratio;
+
+            if (channel % 2 != 0)
+                d *= table.oddChannelRatio;
+
+            return juce::jlimit(0.0f, (float) maxDelay, d);
+        }
+
+        /** The sample written 'age' frames before the current one. */
+        SampleType at(int channel, int age) const
+        {
+            auto& lane = history[(size_t) channel];
+            auto index = (frame - age) % (int) lane.size();
+            return frame - age < 0 ? SampleType() : lane[(size_t) (index < 0 ? index + (int) lane.size() : index)];
+        }
+
+        SampleType read(int channel, float d, SampleType& s) const
+        {
+            using Quality = DelayInterpolation::Quality;
+
+            auto whole = (int) std::floor(d);
+            auto frac = d - (float) whole;
+
+            switch (quality)
+            {
+                case Quality::none:
+                    return at(channel, juce::roundToInt(d));
+
+                case Quality::lagrange3:
+                {
+                    if (whole >= 1) { --whole; frac += 1.0f; }
+
+                    auto f = (SampleType) frac;
+                    auto d1 = f - 1, d2 = f - 2, d3 = f - 3;
+                    auto c1 = d1 * d2 * d3 * (SampleType) (-1.0 / 6.0);
+                    auto c2 = d2 * d3 * (SampleType) 0.5;
+                    auto c3 = d1 * d3 * (SampleType) -0.5;
+                    auto c4 = d1 * d2 * (SampleType) (1.0 / 6.0);
+
+                    return at(channel, whole) * c1
+                         + f * (at(channel, whole + 1) * c2 + at(channel, whole + 2) * c3 + at(channel, whole + 3) * c4);
+                }
+
+                case Quality::thiran:
+                {
+                    if (frac < 0.618f && whole >= 1) { --whole; frac += 1.0f; }
+
+                    auto alpha = (SampleType) ((1.0f - frac) / (1.0f + frac));
+                    auto y = frac == 0.0f ? at(channel, whole) : at(channel, whole + 1) + alpha * (at(channel, whole) - s);
+                    s = y;
+                    return y;
+                }
+
+                case Quality::linear:
+                default:
+                    return at(channel, whole) + (SampleType) frac * (at(channel, whole + 1) - at(channel, whole));
+            }
+        }
+
+        int numChannels = 2, maxDelay = 0, frame = 0;
+        std::vector<std::vector<SampleType>> history; // One plain circular buffer per channel, indexed by frame number
+        TapTable table;
+        DelayInterpolation::Quality quality = DelayInterpolation::Quality::linear;
+
+        std::array<std::array<SampleType, 16>, TapTable::maxTaps> state {}, fadeState {}, feedbackState {}, fadeFeedbackState {};
+        float latencyCompensation = 0.0f;
+
+        bool loopEnabled = false;
+        SampleType loopG = 0, loopK1 = 0, loopH = 0, loop1[16] = {}, loop2[16] = {};
+        float fadeFromDelay = 0.0f;
+        int fadeLength = 0, fadePosition = 0;
+
+        float wowDepth = 0.0f, flutterDepth = 0.0f, wowIncrement = 0.0f, flutterIncrement = 0.0f, wowPhase = 0.0f, flutterPhase = 0.0f;
+    };
+
+    //==============================================================================
+    /** The long delay on its own, one frame at a time - the reference for PagedDelay. One plain circular buffer as long as the
+        paged ring would be: a whole number of pages, growing by pages once the write head comes round to its end wanting a longer
+        delay, and until then holding the delay at the longest it can give. A change of delay crossfades from the old head; one
+        that comes while a crossfade is running waits for it to end.
+
+        Memory is counted in pages as well. A page gets some when the write head reaches it and the pool has one, and a frame
+        written to a page without any is lost. The output is read latencyCompensation frames early, the feedback (and a frozen
+        loop) at the full delay.
+    */
+    template <typename SampleType>
+    class LongDelay
+    {
+    public:
+        static constexpr int pageFrames = 1 << 13; // The same as PagedDelay's
+
+        /** Starts with the pages for delayInSamples already in the pool, like PagedDelay::prepare(). */
+        void prepare(int numChannelsToUse, int delayInSamples, int latencyCompensation = 0, int maximumDelayInSamples = 0)
+        {
+            numChannels = numChannelsToUse;
+            maxDelay = juce::jmax(delayInSamples, maximumDelayInSamples);
+            maxPages = getPagesFor(maxDelay);
+            advance = juce::jmax(0, latencyCompensation);
+            history.assign((size_t) (maxPages * pageFrames * numChannels), SampleType());
+            hasMemory.assign((size_t) maxPages, false);
+
+            delay = targetDelay = delayInSamples;
+            numRingPages = getPagesFor(delay);
+            wantedPages = numRingPages;
+            numAllocated = numInPool = 0;
+            position = fadeLength = fadePosition = 0;
+            allocate();
+        }
+
+        /** As PagedDelay::setDelay(). */
+        void setDelay(int delayInSamples, int crossfadeLength)
+        {
+            targetDelay = juce::jlimit(1, maxDelay, delayInSamples);
+            targetFadeLength = juce::jmax(1, crossfadeLength);
+            wantedPages = juce::jmax(numRingPages, getPagesFor(targetDelay));
+        }
+
+        /** Puts as many pages in the pool as the delay still needs, as PagedDelay::allocatePages(). */
+        void allocate()
+        {
+            auto wanted = juce::jmin(maxPages, wantedPages);
+            numInPool += juce::jmax(0, wanted - numAllocated);
+            numAllocated = juce::jmax(numAllocated, wanted);
+        }
+
+        void processFrame(SampleType* frame, float feedback, float wetGain, bool rotate, bool freeze)
+        {
+            if (position == numRingPages * pageFrames)
+            {
+                if (juce::jmin(maxPages, getPagesFor(targetDelay)) > numRingPages)
+                    numRingPages = juce::jmin(maxPages, getPagesFor(targetDelay));
+                else
+                    position = 0;
+            }
+
+            auto newDelay = juce::jmin(targetDelay, numRingPages * pageFrames - 1);
+
+            if (newDelay != delay && fadePosition >= fadeLength)
+            {
+                fadeFromDelay = delay;
+                delay = newDelay;
+                fadeLength = targetFadeLength;
+                fadePosition = 0;
+            }
+
+            auto page = (size_t) (position / pageFrames);
+
+            if (! hasMemory[page] && numInPool > 0)
+            {
+                hasMemory[page] = true;
+                --numInPool;
+            }
+
+            auto fading = fadePosition < fadeLength;
+            auto fadeIn = fading ? (SampleType) ((float) (fadePosition + 1) / (float) fadeLength) : SampleType(1);
+            SampleType wet[16], fed[16];
+
+            for (int c = 0; c < numChannels; ++c)
+            {
+                wet[c] = at(juce::jmax(1, delay - advance), c);
+                fed[c] = at(delay, c);
+
+                if (fading)
+                {
+                    auto oldWet = at(juce::jmax(1, fadeFromDelay - advance), c), oldFed = at(fadeFromDelay, c);
+                    wet[c] = oldWet + fadeIn * (wet[c] - oldWet);
+                    fed[c] = oldFed + fadeIn * (fed[c] - oldFed);
+                }
+            }
+
+            for (int c = 0; c < numChannels; ++c)
+            {
+                auto written = freeze ? fed[c] : frame[c] + (SampleType) feedback * fed[rotate ? (c + numChannels - 1) % numChannels : c];
+
+                if (hasMemory[page])
+                    history[(size_t) (position * numChannels + c)] = written;
+
+                frame[c] = wet[c] * (SampleType) wetGain;
+            }
+
+            ++position;
+
+            if (fading)
+                ++fadePosition;
+        }
+
+    private:
+        static int getPagesFor(int delayInSamples) { return delayInSamples / pageFrames + 1; }
+
+        /** What the ring holds age frames behind the write head. */
+        SampleType at(int age, int channel) const
+        {
+            auto index = position - age;
+            return history[(size_t) ((index < 0 ? index + numRingPages * pageFrames : index) * numChannels + channel)];
+        }
+
+        int numChannels = 2, maxDelay = 1, maxPages = 1, advance = 0;
+        std::vector<SampleType> history;
+        std::vector<bool> hasMemory;
+        int numRingPages = 1, position = 0, wantedPages = 0, numAllocated = 0, numInPool = 0;
+        int delay = 1, targetDelay = 1, targetFadeLength = 1, fadeFromDelay = 0, fadeLength = 0, fadePosition = 0;
+    };
+
+    //==============================================================================
+    /** The whole of processBlock with settled parameters - wet filter, delay and equal power mix. The reference for the processor. */
+    template <typename SampleType>
+    class Processor
+    {
+    public:
+        void prepare(double newSampleRate, int numChannelsToUse, float maxDelayTimeMs = 3000.0f)
+        {
+            sampleRate = newSampleRate;
+            numChannels = numChannelsToUse;
+            maxDelayMs = maxDelayTimeMs;
+            delay.prepare(numChannels, (int) std::ceil((maxDelayTimeMs + WowFlutter::maxDepthMs) * sampleRate / 1000.0));
+            s1.assign((size_t) numChannels, SampleType());
+            s2.assign((size_t) numChannels, SampleType());
+        }
+
+        void setParameters(const ParameterSnapshot& newParameters)
+        {
+            auto wasLongDelay = parameters.longDelay;
+            parameters = newParameters;
+
+            // Back from the long delay, the multi-tap one starts empty. The long one always does here, as it's prepared again below
+            if (wasLongDelay && ! parameters.longDelay)
+                delay.reset();
+
+            // Tempo sync - both delay times become the note division at the tempo
+            if (parameters.sync)
+            {
+                auto delayMs = TempoSync::getDelayMs(parameters.division, bpm);
+                parameters.delayTimeMs = juce::jmin(delayMs, maxDelayMs);
+                parameters.longTimeSeconds = juce::jlimit(0.5f, 60.0f, delayMs / 1000.0f);
+            }
+
+            // Delay times that crossfade instead of gliding are read at the nearest whole sample, unless wow or flutter moves them
+            auto wholeSamples = parameters.transition == TempoSync::Transition::crossfade && parameters.wow <= 0.0f && parameters.flutter <= 0.0f;
+
+            delay.setTapTable(TapPatterns::get(parameters.tapPattern));
+            delay.setQuality(wholeSamples ? DelayInterpolation::Quality::none : parameters.quality);
+
+            // The input low pass can run oversampled through JUCE's half-band IIRs. The first pass of the echoes is read that much
+            // sooner to make up for their latency, the feedback isn't - only the input is late. Inside the feedback loop it always
+            // runs at the base rate
+            auto factorLog2 = parameters.loopFilter && ! parameters.longDelay ? 0 : juce::jlimit(0, 2, parameters.oversampling);
+            oversampler.reset();
+            latency = 0.0f;
+
+            if (factorLog2 > 0)
+            {
+                oversampler = std::make_unique<juce::dsp::Oversampling<SampleType>>((size_t) numChannels, (size_t) factorLog2,
+                                                                                   juce::dsp::Oversampling<SampleType>::filterHalfBandPolyphaseIIR);
+                oversampler->initProcessing(maxBlockSize);
+                latency = (float) oversampler->getLatencyInSamples();
+            }
+
+            // TPT state variable low pass, prewarped at the cutoff - on the input, or inside the feedback loop
+            auto filterRate = sampleRate * (double) (1 << factorLog2);
+            auto fc = juce::jlimit((SampleType) 1, (SampleType) (filterRate * 0.49), (SampleType) parameters.lpf);
+            g = std::tan(juce::MathConstants<SampleType>::pi * fc / (SampleType) filterRate);
+            k1 = (SampleType) 1 / (SampleType) juce::jmax(parameters.q, 0.01f) + g;
+            h = (SampleType) 1 / ((SampleType) 1 + g * k1);
+
+            cutoff.reset(filterRate, 0.02);
+            cutoff.setCurrentAndTargetValue(parameters.lpf);
+            filterRateHz = filterRate;
+
+            delay.setFeedbackLoop(parameters.loopFilter, g, k1, h);
+            delay.setLatencyCompensation(latency);
+            delay.setModulation(parameters.wow, parameters.flutter, sampleRate);
+
+            // The long delay takes the place of the multi-tap one, at a whole number of samples
+            if (parameters.longDelay)
+                longDelay.prepare(numChannels, juce::jmax(1, juce::roundToInt(parameters.longTimeSeconds * sampleRate)), juce::roundToInt(latency));
+        }
+
+        /** Moves the input low pass's cutoff the way automation does - a 20ms multiplicative glide to the new value, with the
+            coefficients worked out again every sample on the way. setParameters() jumps straight to its cutoff instead.
+        */
+        void setCutoff(float newCutoffHz) { cutoff.setTargetValue(newCutoffHz); }
+
+        /** The host tempo synced delay times follow. Takes effect at the next setParameters(). */
+        void setTempo(double newBpm) { bpm = newBpm; }
+
+        void process(juce::AudioBuffer<SampleType>& buffer)
+        {
+            jassert(buffer.getNumSamples() <= maxBlockSize);
+
+            auto delaySamples = (float) (parameters.delayTimeMs * sampleRate / 1000.0);
+            auto angle = parameters.wetDry * juce::MathConstants<float>::halfPi;
+            auto wetGain = std::sin(angle), dryGain = std::cos(angle);
+
+            juce::AudioBuffer<SampleType> wet(buffer);
+
+            if (parameters.longDelay ? ! parameters.freeze : ! parameters.loopFilter)
+            {
+                auto block = juce::dsp::AudioBlock<SampleType>(wet).getSubsetChannelBlock(0, (size_t) numChannels);
+
+                if (oversampler != nullptr)
+                {
+                    auto upsampled = oversampler->processSamplesUp(block);
+                    filter(upsampled);
+                    oversampler->processSamplesDown(block);
+                }
+                else
+                {
+                    filter(block);
+                }
+            }
+
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+            {
+                SampleType frame[16];
+
+                for (int c = 0; c < numChannels; ++c)
+                    frame[c] = wet.getSample(c, i);
+
+                if (parameters.longDelay)
+                    longDelay.processFrame(frame, parameters.feedback, wetGain, parameters.rotate, parameters.freeze);
+                else
+                    delay.processFrame(frame, delaySamples, parameters.feedback, wetGain, parameters.rotate);
+
+                for (int c = 0; c < numChannels; ++c)
+                    buffer.setSample(c, i, frame[c] + buffer.getSample(c, i) * (SampleType) dryGain);
+            }
+        }
+
+        /** Longest buffer process() takes. */
+        static constexpr int maxBlockSize = 8192;
+
+    private:
+        void filter(const juce::dsp::AudioBlock<SampleType>& block)
+        {
+            // Every sample's coefficients, gliding or not
+            std::vector<SampleType> gs, k1s, hs;
+
+            for (size_t i = 0; i < block.getNumSamples(); ++i)
+            {
+                if (cutoff.isSmoothing())
+                {
+                    auto fc = juce::jlimit((SampleType) 1, (SampleType) (filterRateHz * 0.49), (SampleType) cutoff.getNextValue());
+                    g = std::tan(juce::MathConstants<SampleType>::pi * fc / (SampleType) filterRateHz);
+                    k1 = (SampleType) 1 / (SampleType) juce::jmax(parameters.q, 0.01f) + g;
+                    h = (SampleType) 1 / ((SampleType) 1 + g * k1);
+                }
+
+                gs.push_back(g);
+                k1s.push_back(k1);
+                hs.push_back(h);
+            }
+
+            for (size_t c = 0; c < block.getNumChannels(); ++c)
+            {
+                auto* data = block.getChannelPointer(c);
+
+                for (size_t i = 0; i < block.getNumSamples(); ++i)
+                {
+                    auto hp = (data[i] - k1s[i] * s1[c] - s2[c]) * hs[i];
+                    auto bp = gs[i] * hp + s1[c];
+                    s1[c] = gs[i] * hp + bp;
+                    auto lp = gs[i] * bp + s2[c];
+                    s2[c] = gs[i] * bp + lp;
+                    data[i] = lp;
+                }
+            }
+        }
+
+        double sampleRate = 44100.0, bpm = TempoSync::defaultBpm;
+        int numChannels = 2;
+        float maxDelayMs = 3000.0f;
+        ParameterSnapshot parameters;
+        Delay<SampleType> delay;
+        LongDelay<SampleType> longDelay;
+
+        std::unique_ptr<juce::dsp::Oversampling<SampleType>> oversampler;
+        float latency = 0.0f; // The oversampler's, in base rate samples
+
+        SampleType g = 0, k1 = 0, h = 0;
+        std::vector<SampleType> s1, s2;
+        juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> cutoff { 600.0f };
+        double filterRateHz = 44100.0;
+    };
+}
@@ -0,0 +1,55 @@
+/*
+  ==============================================================================
+
+    TestSignals.h
+
+    Small helpers shared by the golden tests and the benchmarks.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../Source/ParameterSnapshot.h"
+
+namespace TestSignals
+{
+    /** White noise between -1 and 1 on every channel. */
+    template <typename SampleType>
+    inline void fillWithNoise(juce::AudioBuffer<SampleType>& buffer, juce::Random& random)
+    {
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+        {
+            auto* data = buffer.getWritePointer(channel);
+
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+                data[i] = (SampleType) (random.nextFloat() * 2.0f - 1.0f);
+        }
+    }
+
+    /** Sets every parameter from a snapshot, the way a host would. */
+    inline void applyParameters(juce::AudioProcessor& processor, const ParameterSnapshot& snapshot)
+    {
+        auto values = snapshot.toValues();
+
+        for (auto* param : processor.getParameters())
+            if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(param))
+                for (int i = 0; i < ParameterSnapshot::numValues; ++i)
+                    if (ranged->paramID == ParameterSnapshot::parameterIDs[i])
+                        ranged->setValueNotifyingHost(ranged->convertTo0to1(values[(size_t) i]));
+    }
+
+    /** Largest difference between two buffers of the same size. */
+    template <typename SampleType>
+    inline double maxDifference(const juce::AudioBuffer<SampleType>& a, const juce::AudioBuffer<SampleType>& b)
+    {
+        auto difference = 0.0;
+
+        for (int channel = 0; channel < a.getNumChannels(); ++channel)
+            for (int i = 0; i < a.getNumSamples(); ++i)
+                difference = juce::jmax(difference, (double) std::abs(a.getSample(channel, i) - b.getSample(channel, i)));
+
+        return difference;
+    }
+}